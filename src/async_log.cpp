@@ -0,0 +1,139 @@
+// async_log.cpp
+//
+// Ring buffer and writer thread of the asynchronous log, see async_log.hpp.
+
+#include "async_log.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint64_t RING_CAPACITY = uint64_t(1) << 20;
+// The writer wakes up this often: at most a few hundred write syscalls per second, whatever the call rate.
+const std::chrono::milliseconds DRAIN_PERIOD(5);
+const std::chrono::microseconds FULL_RING_WAIT(100);
+
+struct AsyncLog {
+    FILE *file = nullptr;
+    bool echo_stdout = false;
+    std::vector<char> ring = std::vector<char>(RING_CAPACITY);
+    // Monotonic byte counters: [tail, head) is waiting to be written.
+    // head is only written by the logging thread, tail only by the writer thread.
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    std::atomic<bool> stop{false};
+    std::thread writer;
+};
+
+std::unique_ptr<AsyncLog> state;
+
+// Joins the writer if the library is unloaded without batsim_edc_deinit(): destroying a joinable
+// std::thread would terminate the process. Declared after state, so it runs before state is destroyed.
+struct CloseAtExit {
+    ~CloseAtExit() { async_log_close(); }
+} close_at_exit;
+
+void write_out(const char *data, size_t size) {
+    fwrite(data, 1, size, state->file);
+    if (state->echo_stdout) {
+        fwrite(data, 1, size, stdout);
+    }
+}
+
+// Writes everything logged so far, as at most two fwrite() (the ring may wrap) and one fflush().
+void drain() {
+    uint64_t head = state->head.load(std::memory_order_acquire);
+    uint64_t tail = state->tail.load(std::memory_order_relaxed);
+    if (head == tail) {
+        return;
+    }
+    size_t begin = static_cast<size_t>(tail % RING_CAPACITY);
+    size_t size = static_cast<size_t>(head - tail);
+    size_t first = std::min(size, static_cast<size_t>(RING_CAPACITY) - begin);
+    write_out(state->ring.data() + begin, first);
+    if (size > first) {
+        write_out(state->ring.data(), size - first);
+    }
+    fflush(state->file);
+    if (state->echo_stdout) {
+        fflush(stdout);
+    }
+    state->tail.store(head, std::memory_order_release);
+}
+
+void writer_loop() {
+    while (!state->stop.load(std::memory_order_acquire)) {
+        drain();
+        std::this_thread::sleep_for(DRAIN_PERIOD);
+    }
+    drain();
+}
+
+} // namespace
+
+bool async_log_open(const std::string &path, bool echo_stdout) {
+    async_log_close();
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    setvbuf(file, nullptr, _IOFBF, 1 << 16);
+    state = std::make_unique<AsyncLog>();
+    state->file = file;
+    state->echo_stdout = echo_stdout;
+    state->writer = std::thread(writer_loop);
+    return true;
+}
+
+void log_message(const char *format, ...) {
+    if (state == nullptr) {
+        return;
+    }
+    char buffer[1024];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length <= 0) {
+        return;
+    }
+    uint64_t size = std::min(static_cast<uint64_t>(length), static_cast<uint64_t>(sizeof(buffer) - 1));
+
+    uint64_t head = state->head.load(std::memory_order_relaxed);
+    while (RING_CAPACITY - (head - state->tail.load(std::memory_order_acquire)) < size) {
+        std::this_thread::sleep_for(FULL_RING_WAIT);
+    }
+    size_t begin = static_cast<size_t>(head % RING_CAPACITY);
+    size_t first = std::min(static_cast<size_t>(size), static_cast<size_t>(RING_CAPACITY) - begin);
+    std::copy(buffer, buffer + first, state->ring.data() + begin);
+    std::copy(buffer + first, buffer + size, state->ring.data());
+    state->head.store(head + size, std::memory_order_release);
+}
+
+void async_log_flush() {
+    if (state == nullptr) {
+        return;
+    }
+    uint64_t head = state->head.load(std::memory_order_relaxed);
+    while (state->tail.load(std::memory_order_acquire) < head) {
+        std::this_thread::sleep_for(FULL_RING_WAIT);
+    }
+}
+
+void async_log_close() {
+    if (state == nullptr) {
+        return;
+    }
+    state->stop.store(true, std::memory_order_release);
+    state->writer.join();
+    fclose(state->file);
+    state.reset();
+}
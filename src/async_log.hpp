@@ -0,0 +1,28 @@
+// async_log.hpp
+//
+// Asynchronous writer for the schedulers' log file (the backfill counter lines read by
+// extract_backfill_stats() in scripts/analyze_scheduler_performance.py).
+// log_message() formats the line on the calling thread and copies it into a lock-free
+// single-producer/single-consumer ring buffer; a background thread drains the buffer every
+// few milliseconds and writes everything it found with one fwrite()/fflush(), so the decision
+// path no longer does a write syscall per call. Lines are written whole and in order.
+// When the buffer is full, log_message() waits for the writer rather than dropping lines,
+// since the analysis only reads the last one.
+// async_log_close(), called from batsim_edc_deinit(), drains the buffer and closes the file.
+
+#pragma once
+
+#include <string>
+
+// Opens (truncates) path and starts the writer thread. With echo_stdout, lines are also written to stdout.
+// Returns false if the file cannot be opened; log_message() then does nothing.
+bool async_log_open(const std::string &path, bool echo_stdout);
+
+// Appends a printf-formatted message (at most 1023 characters) to the log.
+void log_message(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+// Waits until everything logged so far is written to the file.
+void async_log_flush();
+
+// Flushes, stops the writer thread and closes the file.
+void async_log_close();
@@ -0,0 +1,149 @@
+// availability_profile.cpp
+//
+// Step function of free hosts over time, see availability_profile.hpp.
+
+#include "availability_profile.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+void AvailabilityProfile::reset(uint32_t nb_hosts) {
+    free_.clear();
+    free_[0] = nb_hosts;
+}
+
+double AvailabilityProfile::earliest_start(double from, double duration, uint32_t nb_hosts, double latest) const {
+    if (free_.empty()) {
+        return NEVER;
+    }
+    auto it = free_.upper_bound(from);
+    if (it != free_.begin()) {
+        --it;
+    }
+    double start = from;
+    // Every failed window restarts at the breakpoint that made it fail, so each breakpoint is
+    // visited at most twice.
+    while (it != free_.end()) {
+        if (it->second < nb_hosts) {
+            ++it;
+            if (it == free_.end()) {
+                return NEVER;
+            }
+            start = it->first;
+            if (start > latest) {
+                return NEVER;
+            }
+            continue;
+        }
+        double end = (duration > 0) ? start + duration : NEVER;
+        auto check = std::next(it);
+        while (check != free_.end() && check->first < end && check->second >= nb_hosts) {
+            ++check;
+        }
+        if (check == free_.end() || check->first >= end) {
+            return start;
+        }
+        it = check;
+    }
+    return NEVER;
+}
+
+double AvailabilityProfile::free_since(double time, uint32_t nb_hosts, double from) const {
+    auto it = free_.lower_bound(time);
+    double since = time;
+    while (since > from && it != free_.begin()) {
+        --it;
+        if (it->second < nb_hosts) {
+            break;
+        }
+        since = std::max(it->first, from);
+    }
+    return since;
+}
+
+bool AvailabilityProfile::fits(double begin, double end, uint32_t nb_hosts) const {
+    auto it = free_.upper_bound(begin);
+    if (it != free_.begin()) {
+        --it;
+    }
+    for (; it != free_.end() && it->first < end; ++it) {
+        if (it->second < nb_hosts) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AvailabilityProfile::reserve(double begin, double end, uint32_t nb_hosts) {
+    if (nb_hosts == 0 || begin >= end) {
+        return;
+    }
+    auto it = split(begin);
+    auto last = (end == NEVER) ? free_.end() : split(end);
+    for (; it != last; ++it) {
+        it->second -= nb_hosts;
+    }
+    merge(begin);
+    if (end != NEVER) {
+        merge(end);
+    }
+}
+
+void AvailabilityProfile::release(double begin, double end, uint32_t nb_hosts) {
+    if (nb_hosts == 0 || begin >= end) {
+        return;
+    }
+    auto it = split(begin);
+    auto last = (end == NEVER) ? free_.end() : split(end);
+    for (; it != last; ++it) {
+        it->second += nb_hosts;
+    }
+    merge(begin);
+    if (end != NEVER) {
+        merge(end);
+    }
+}
+
+void AvailabilityProfile::forget_before(double now) {
+    if (free_.empty() || free_.begin()->first >= now) {
+        return;
+    }
+    auto it = split(now);
+    free_.erase(free_.begin(), it);
+}
+
+uint32_t AvailabilityProfile::free_at(double time) const {
+    auto it = free_.upper_bound(time);
+    if (it == free_.begin()) {
+        return 0;
+    }
+    return std::prev(it)->second;
+}
+
+uint32_t AvailabilityProfile::max_free(double begin, double end) const {
+    auto it = free_.upper_bound(begin);
+    if (it != free_.begin()) {
+        --it;
+    }
+    uint32_t most = 0;
+    for (; it != free_.end() && it->first < end; ++it) {
+        most = std::max(most, it->second);
+    }
+    return most;
+}
+
+std::map<double, uint32_t>::iterator AvailabilityProfile::split(double time) {
+    auto it = free_.lower_bound(time);
+    if (it != free_.end() && it->first == time) {
+        return it;
+    }
+    uint32_t value = (it == free_.begin()) ? 0 : std::prev(it)->second;
+    return free_.emplace_hint(it, time, value);
+}
+
+void AvailabilityProfile::merge(double time) {
+    auto it = free_.find(time);
+    if (it != free_.end() && it != free_.begin() && std::prev(it)->second == it->second) {
+        free_.erase(it);
+    }
+}
@@ -0,0 +1,59 @@
+// availability_profile.hpp
+//
+// Number of free hosts over time, for the schedulers that plan a reservation for every waiting job.
+// The profile is a step function stored as breakpoints: profile[t] hosts are free from t until the
+// next breakpoint, the last one lasting forever. Unlike SlotProfile (one set of hosts per second,
+// see slot_profile.hpp), its size only depends on the number of running and reserved jobs, not on
+// their walltimes, and times do not need to be whole seconds.
+// Reservations are counts: the hosts themselves are chosen when the job starts, among the hosts free
+// at that time, which there are enough of as long as jobs do not outlive their reservation.
+// An end of +infinity reserves hosts forever (jobs without walltime).
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+
+class AvailabilityProfile {
+public:
+    static constexpr double NEVER = std::numeric_limits<double>::infinity();
+
+    // Every host free from time 0 on.
+    void reset(uint32_t nb_hosts);
+
+    // Earliest time >= from from which nb_hosts hosts stay free during duration
+    // (forever if duration <= 0). NEVER if there is none, or none before latest.
+    double earliest_start(double from, double duration, uint32_t nb_hosts, double latest = NEVER) const;
+
+    // Earliest time t >= from such that nb_hosts hosts are free during all of [t, time),
+    // walking back from time (time itself if the hosts just before it are busy).
+    double free_since(double time, uint32_t nb_hosts, double from) const;
+
+    // Whether nb_hosts hosts are free during all of [begin, end).
+    bool fits(double begin, double end, uint32_t nb_hosts) const;
+
+    // Takes (resp. gives back) nb_hosts hosts during [begin, end).
+    void reserve(double begin, double end, uint32_t nb_hosts);
+    void release(double begin, double end, uint32_t nb_hosts);
+
+    // Forgets the profile before now, which the schedulers will not look at anymore.
+    void forget_before(double now);
+
+    uint32_t free_at(double time) const;
+    // Most hosts free at once during [begin, end).
+    uint32_t max_free(double begin, double end) const;
+    size_t nb_breakpoints() const { return free_.size(); }
+
+    // Reservation end of a job of this walltime started at begin.
+    static double end_of(double begin, double walltime) { return walltime > 0 ? begin + walltime : NEVER; }
+
+private:
+    // Makes time a breakpoint, returns it.
+    std::map<double, uint32_t>::iterator split(double time);
+    // Removes the breakpoint at time if it does not change the number of free hosts.
+    void merge(double time);
+
+    std::map<double, uint32_t> free_;
+};
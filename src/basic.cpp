@@ -1,28 +1,54 @@
-// backfilling.cpp
+// basic.cpp
 //
-// A simple backfilling scheduler implementation for Batsim.
+// A conservative backfilling scheduler implementation for Batsim.
 // This implementation uses a list (jobs) for the pending jobs queue,
 // a set for available resources, and maps for running jobs and their allocations.
+// Every waiting job holds a reservation: when it is submitted, it is planned at the earliest time
+// the availability profile (availability_profile.hpp) has enough hosts for its whole walltime,
+// after the reservations of all the jobs submitted before it. A later job can thus only be
+// backfilled into a hole that delays none of them. Jobs start when their reservation is due.
+// With "planner": "local_search" in the initialization data, every decision call then tries to
+// improve the plan of the first waiting jobs by reordering them (see improve_plan()).
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <list>
+#include <map>
+#include <random>
 #include <set>
 #include <unordered_map>
 #include <string>
 #include <cstdio>
 #include <iterator>
 #include <sstream>
-#include <fstream>
+#include <vector>
 #include <batprotocol.hpp>
 #include <intervalset.hpp>
 #include "batsim_edc.h"
+#include "edc_config.hpp"
+#include "async_log.hpp"
+#include "availability_profile.hpp"
+#include "decision_stats.hpp"
+#include "log_level.hpp"
+#include "online_metrics.hpp"
+#include "msg_trace.hpp"
+#include "slot_profile.hpp"
 
 using namespace batprotocol;
 
+struct SchedJob;
+typedef std::multimap<double, SchedJob*> ReservationIndex;
+
 struct SchedJob {
     std::string job_id;
     uint8_t nb_hosts;
-    uint32_t walltime;  // Added walltime field to track job duration
+    double walltime;  // <= 0 if the workload gives none: the hosts are then reserved forever
+    uint64_t submission_index;  // Queue order
+    std::list<SchedJob*>::iterator queue_position;  // In jobs, while waiting
+    ReservationIndex::iterator reservation;  // In reservations, while waiting
+    double start_time;  // Planned start while waiting, actual start once running
 };
 
 // Global variables for scheduler state
@@ -32,35 +58,71 @@ static std::list<SchedJob*> *jobs = nullptr;
 static std::unordered_map<std::string, SchedJob*> running_jobs;
 static std::unordered_map<std::string, std::set<uint32_t>> job_allocations;
 static uint32_t platform_nb_hosts = 0;
-static std::vector<std::set<uint32_t>> available_res;
+static std::set<uint32_t> available_res;
+static AvailabilityProfile profile;  // Hosts used by running jobs and reserved for waiting jobs
+static ReservationIndex reservations;  // Waiting jobs by planned start
+static uint64_t next_submission_index = 0;
+static std::set<uint64_t> requested_calls;  // Times of the calls asked for with add_call_me_later()
+
+// Times closer than this are the same time (Batsim's clock is a double).
+static const double TIME_EPSILON = 1e-6;
 static uint32_t backfill_success_count = 0;
 static uint32_t contiguous_backfill_count = 0;
 static uint32_t non_contiguous_backfill_count = 0;
-static std::ofstream log_file;
+
+// Local search planner, from the initialization data
+static bool local_search = false;
+static size_t planner_iterations = 200;   // Plans it may evaluate per decision call
+static double planner_budget_ms = 0;      // Time it may take per decision call, if > 0
+static size_t planner_window = 32;        // Waiting jobs, from the front of the queue, it reorders
+static std::mt19937 planner_random;
+static bool plan_changed = true;  // Whether the plan changed since the last search (else it is skipped)
 
 // -------------------------
 // Initialization function
 // -------------------------
 extern "C" uint8_t batsim_edc_init(const uint8_t *data, uint32_t size, uint32_t flags) {
-    (void)data; // Unused
-    (void)size; // Unused
-
     format_binary = ((flags & BATSIM_EDC_FORMAT_BINARY) != 0);
     if ((flags & (BATSIM_EDC_FORMAT_BINARY | BATSIM_EDC_FORMAT_JSON)) != flags) {
         printf("Unknown flags used, cannot initialize backfilling scheduler.\n");
         return 1;
     }
     
+    EdcConfig config;
+    if (!parse_edc_config(data, size, config) || !log_level_init(config)) {
+        return 1;
+    }
+    if (!msg_trace_open(config, data, size, flags)) {
+        return 1;
+    }
+    std::string planner = config.get_string("planner", "greedy");
+    if (planner != "greedy" && planner != "local_search") {
+        printf("Unknown planner '%s' (expected greedy or local_search)\n", planner.c_str());
+        return 1;
+    }
+    local_search = (planner == "local_search");
+    planner_iterations = static_cast<size_t>(std::max(0.0, config.get_number("planner_iterations", 200)));
+    planner_budget_ms = config.get_number("planner_budget_ms", 0);
+    planner_window = static_cast<size_t>(std::max(2.0, config.get_number("planner_window", 32)));
+    planner_random.seed(static_cast<uint32_t>(config.get_number("planner_seed", 1)));
+
     mb = new MessageBuilder(!format_binary);
     jobs = new std::list<SchedJob*>();
 
-    log_file.open("basic_log.txt", std::ios::out | std::ios::trunc);
-    if (!log_file.is_open()) {
+    // The library may be initialized several times in the same process (e.g. by the sweep tool)
+    backfill_success_count = 0;
+    contiguous_backfill_count = 0;
+    non_contiguous_backfill_count = 0;
+
+    decision_stats_init(config, "basic");
+    online_metrics_init(config, "basic");
+
+    if (!async_log_open(config.get_string("log_file", "basic_log.txt"), false)) {
         printf("Warning: Could not open log file for writing\n");
     } else {
-        log_file << "EASY Backfilling Scheduler Log\n";
-        log_file << "FORMAT: <total_backfills> <contiguous_backfills> <non_contiguous_backfills>\n";
-        log_file << "=============================\n\n";
+        log_message("Conservative Backfilling Scheduler Log\n");
+        log_message("FORMAT: <total_backfills> <contiguous_backfills> <non_contiguous_backfills>\n");
+        log_message("=============================\n\n");
     }
     
     return 0;
@@ -88,42 +150,345 @@ extern "C" uint8_t batsim_edc_deinit() {
     running_jobs.clear();
     job_allocations.clear();
     available_res.clear();
-    // Close log file
-    if (log_file.is_open()) {
-        log_file.close();
-    }
+    reservations.clear();
+    requested_calls.clear();
+    next_submission_index = 0;
+    plan_changed = true;
+    decision_stats_dump();
+    online_metrics_dump();
+    msg_trace_close();
+
+    async_log_close();
 
     return 0;
 }
 
-void log_message(const char* format, ...) {
-    char buffer[1024];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
-    va_end(args);
-    // Write to log file if open
-    if (log_file.is_open()) {
-        log_file << buffer;
-        log_file.flush();  // Ensure it's written immediately
+// -------------------------
+// Reservations
+// -------------------------
+// Reserves hosts for job at the earliest time they are free for its whole walltime.
+static void plan_job(SchedJob* job, double current_time) {
+    job->start_time = profile.earliest_start(current_time, job->walltime, job->nb_hosts);
+    profile.reserve(job->start_time, AvailabilityProfile::end_of(job->start_time, job->walltime), job->nb_hosts);
+    job->reservation = reservations.emplace(job->start_time, job);
+    plan_changed = true;
+}
+
+// Moves the window of a job whose reservation was due before current_time (a call comes back at
+// a whole second) so that it starts now, if the profile has room for it. Otherwise plans it again.
+// Returns true if the job can start now.
+static bool catch_up(SchedJob* job, double current_time) {
+    double planned_end = AvailabilityProfile::end_of(job->start_time, job->walltime);
+    double end = AvailabilityProfile::end_of(current_time, job->walltime);
+    if (planned_end > current_time) {
+        profile.release(current_time, planned_end, job->nb_hosts);
+    }
+    if (profile.fits(current_time, end, job->nb_hosts)) {
+        profile.reserve(current_time, end, job->nb_hosts);
+        job->start_time = current_time;
+        return true;
     }
+    reservations.erase(job->reservation);
+    plan_job(job, current_time);
+    return false;
 }
 
+// Asks Batsim for a call when the earliest reservation is due, unless an event comes by then:
+// reservations that moved earlier are due at times where no job starts or completes.
+static void request_next_call(double current_time) {
+    requested_calls.erase(requested_calls.begin(), requested_calls.upper_bound(static_cast<uint64_t>(current_time + TIME_EPSILON)));
+    if (reservations.empty() || reservations.begin()->first <= current_time + TIME_EPSILON) {
+        return;
+    }
+    uint64_t when = static_cast<uint64_t>(std::ceil(reservations.begin()->first - TIME_EPSILON));
+    if (requested_calls.insert(when).second) {
+        mb->add_call_me_later("wake_up_" + std::to_string(when), TemporalTrigger::make_one_shot(when));
+    }
+}
 
-// Helper function to ensure available_res has enough time slots
-void ensure_time_slot_exists(double time) {
-    size_t time_index = static_cast<size_t>(time);
-    
-    // If the time slot doesn't exist yet, create it and all slots up to it
-    while (available_res.size() <= time_index) {
-        size_t new_index = available_res.size();
-        available_res.push_back(std::set<uint32_t>());
+// Time ranges where hosts were given back (by early completions, or by reservations that moved
+// earlier), disjoint and keyed by begin, with the most hosts free in each of them (an upper bound
+// once jobs move into them).
+struct FreedRange {
+    double end;
+    uint32_t max_free_hosts;
+};
+typedef std::map<double, FreedRange> FreedRanges;
+
+// Adds [begin, end) to freed, merging it with the ranges it touches.
+static void add_freed_range(FreedRanges &freed, double begin, double end) {
+    uint32_t max_free_hosts = profile.max_free(begin, end);
+    auto it = freed.upper_bound(begin);
+    if (it != freed.begin() && std::prev(it)->second.end >= begin) {
+        --it;
+    }
+    while (it != freed.end() && it->first <= end) {
+        begin = std::min(begin, it->first);
+        end = std::max(end, it->second.end);
+        max_free_hosts = std::max(max_free_hosts, it->second.max_free_hosts);
+        it = freed.erase(it);
+    }
+    freed.emplace(begin, FreedRange{end, max_free_hosts});
+}
+
+// Waiting jobs to look at again, in queue order (by submission index).
+typedef std::map<uint64_t, SchedJob*> CompactionWorklist;
+
+// Adds the waiting jobs planned to start during (begin, end], behind moved_job in the queue (if not
+// null) and needing max_free_hosts hosts at most, found from the reservations, which are indexed by
+// planned start.
+static void add_compaction_candidates(CompactionWorklist &worklist, double begin, double end, const SchedJob* moved_job,
+                                      uint32_t max_free_hosts) {
+    for (auto it = reservations.upper_bound(begin + TIME_EPSILON); it != reservations.end() && it->first <= end + TIME_EPSILON;
+         ++it) {
+        SchedJob* job = it->second;
+        if (job->nb_hosts <= max_free_hosts && (moved_job == nullptr || job->submission_index > moved_job->submission_index)) {
+            worklist.emplace(job->submission_index, job);
+        }
+    }
+}
+
+// Moves reservations earlier into the capacity given back by early completions, in queue order.
+// A job only moves if it can slide back (the hosts just before its planned start are free) or jump
+// into a hole that ends before its start and overlaps a freed range, since the rest of the profile
+// only got busier since the job was planned. So only the jobs planned to start after a freed range
+// begins, and small enough for it, are looked at. Both cases are read from the profile without
+// giving the job's reservation back, so a job that cannot move costs a few lookups.
+// When a job moves, the end of its old window is freed in turn, and the jobs behind it in the queue
+// planned to start in it (which may now slide back) join the worklist; the later ones are already
+// in it if they could use the first freed range. The jobs ahead of it were already looked at and
+// keep their reservation, as with a re-plan of the whole queue in order: each job is looked at once
+// per decision call at most, and only if a freed range reaches it.
+// Sets nb_checked to the number of jobs looked at and returns the number of moves.
+static size_t compact_reservations(FreedRanges &freed, double current_time, size_t &nb_checked) {
+    CompactionWorklist worklist;
+    for (const auto &range : freed) {
+        add_compaction_candidates(worklist, range.first, AvailabilityProfile::NEVER, nullptr, range.second.max_free_hosts);
+    }
+    size_t nb_moved = 0;
+    nb_checked = 0;
+    while (!worklist.empty()) {
+        SchedJob* job = worklist.begin()->second;
+        worklist.erase(worklist.begin());
+        nb_checked++;
+        double planned_start = job->start_time;
+        if (planned_start <= current_time + TIME_EPSILON) {
+            continue;
+        }
+        
+        // [t, planned_start) free, the rest of the new window being in the old one.
+        double new_start = profile.free_since(planned_start, job->nb_hosts, current_time);
+        // A whole new window ending before the new start. Any new hole overlaps a freed range
+        // with enough free hosts, so the search starts a walltime before the first one.
+        if (job->walltime > 0) {
+            double latest = new_start - job->walltime;
+            for (auto &range : freed) {
+                if (range.first - job->walltime > latest) {
+                    break;  // This range and the next ones are too late
+                }
+                if (range.second.max_free_hosts >= job->nb_hosts) {
+                    double from = std::max(current_time, range.first - job->walltime);
+                    new_start = std::min(new_start, profile.earliest_start(from, job->walltime, job->nb_hosts, latest));
+                    break;
+                }
+            }
+        }
+        if (new_start >= planned_start - TIME_EPSILON) {
+            continue;
+        }
         
-        // Add all platform resources to the new time slot
-        for (uint32_t i = 0; i < platform_nb_hosts; i++) {
-            available_res[new_index].insert(i);
+        nb_moved++;
+        double planned_end = AvailabilityProfile::end_of(planned_start, job->walltime);
+        double new_end = AvailabilityProfile::end_of(new_start, job->walltime);
+        profile.release(planned_start, planned_end, job->nb_hosts);
+        profile.reserve(new_start, new_end, job->nb_hosts);
+        reservations.erase(job->reservation);
+        job->start_time = new_start;
+        job->reservation = reservations.emplace(new_start, job);
+        // The job took hosts in the ranges its new window overlaps: forget the ones left full.
+        auto range = freed.upper_bound(new_start);
+        if (range != freed.begin()) {
+            --range;
+        }
+        while (range != freed.end() && range->first < new_end) {
+            if (range->second.end > new_start) {
+                range->second.max_free_hosts = profile.max_free(range->first, range->second.end);
+            }
+            range = (range->second.max_free_hosts == 0) ? freed.erase(range) : std::next(range);
+        }
+        if (new_end < planned_end) {
+            double begin = std::max(new_end, planned_start);
+            add_freed_range(freed, begin, planned_end);
+            add_compaction_candidates(worklist, begin, planned_end, job, profile.max_free(begin, planned_end));
         }
     }
+    return nb_moved;
+}
+
+// -------------------------
+// Local search planner
+// -------------------------
+// The greedy plan reserves hosts job after job in queue order, which may leave holes that another
+// order would fill. improve_plan() takes the first planner_window waiting jobs, gives their
+// reservations back (the reservations of the jobs behind them stay, so these jobs are not delayed)
+// and looks for a better order by hill climbing: a random swap of two jobs, or a job moved
+// elsewhere, is kept if planning the jobs in the new order, each at its earliest start, gives an
+// earlier makespan (then a smaller sum of start times). It stops after planner_iterations plans, or
+// when planner_budget_ms runs out if set (the plan then depends on the speed of the machine), or
+// after window^2 moves in a row that did not improve the plan, and keeps the best plan found,
+// which is never worse than the current one. The reservations of the reordered jobs may move later,
+// unlike with the greedy planner.
+// The plans are evaluated in the profile itself: the window's jobs are reserved in the new order,
+// then released, which gives back the exact same profile. The search only runs again once the plan
+// changed (a job was submitted, completed, started or moved), or if the last one improved it.
+struct PlanScore {
+    double makespan;     // Latest end of the planned jobs (start for the jobs without walltime)
+    double total_start;  // Sum of their starts
+};
+
+static bool better_plan(const PlanScore &a, const PlanScore &b) {
+    if (a.makespan < b.makespan - TIME_EPSILON) {
+        return true;
+    }
+    return a.makespan <= b.makespan + TIME_EPSILON && a.total_start < b.total_start - TIME_EPSILON;
+}
+
+static PlanScore score_plan(const std::vector<SchedJob*> &order, const std::vector<double> &starts) {
+    PlanScore score = {0, 0};
+    for (size_t i = 0; i < order.size(); ++i) {
+        double end = AvailabilityProfile::end_of(starts[i], order[i]->walltime);
+        score.makespan = std::max(score.makespan, end == AvailabilityProfile::NEVER ? starts[i] : end);
+        score.total_start += starts[i];
+    }
+    return score;
+}
+
+// Reserves the jobs of order one after the other at their earliest start in the profile, as long as
+// they end by max_makespan: the profile is only searched up to there. Returns false (the first
+// starts.size() jobs being reserved) if one of them cannot.
+static bool plan_in_order(const std::vector<SchedJob*> &order, std::vector<double> &starts, double current_time,
+                          double max_makespan) {
+    starts.clear();
+    for (SchedJob* job : order) {
+        double latest = max_makespan + TIME_EPSILON - std::max(0.0, job->walltime);
+        double start = profile.earliest_start(current_time, job->walltime, job->nb_hosts, latest);
+        if (start > latest) {
+            return false;
+        }
+        starts.push_back(start);
+        profile.reserve(start, AvailabilityProfile::end_of(start, job->walltime), job->nb_hosts);
+    }
+    return true;
+}
+
+// Gives back the reservations made by plan_in_order().
+static void release_plan(const std::vector<SchedJob*> &order, const std::vector<double> &starts) {
+    for (size_t i = 0; i < starts.size(); ++i) {
+        profile.release(starts[i], AvailabilityProfile::end_of(starts[i], order[i]->walltime), order[i]->nb_hosts);
+    }
+}
+
+// The windows the reordered jobs leave are added to freed, for compact_reservations() to move the
+// jobs behind them earlier. Returns the number of plans evaluated.
+static size_t improve_plan(FreedRanges &freed, double current_time) {
+    if (!plan_changed) {
+        return 0;
+    }
+    plan_changed = false;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double, std::milli>(planner_budget_ms);
+    std::vector<SchedJob*> best_order;
+    std::vector<double> best_starts;
+    for (auto it = jobs->begin(); it != jobs->end() && best_order.size() < planner_window; ++it) {
+        best_order.push_back(*it);
+        best_starts.push_back((*it)->start_time);
+    }
+    if (best_order.size() < 2) {
+        return 0;
+    }
+    release_plan(best_order, best_starts);
+    PlanScore best_score = score_plan(best_order, best_starts);
+    bool improved = false;
+
+    std::vector<SchedJob*> order;
+    std::vector<double> starts;
+    std::uniform_int_distribution<size_t> position(0, best_order.size() - 1);
+    size_t max_failures = best_order.size() * best_order.size();
+    size_t nb_failures = 0;
+    size_t nb_evaluated = 0;
+    while (nb_failures < max_failures && nb_evaluated < planner_iterations
+           && (planner_budget_ms <= 0 || std::chrono::steady_clock::now() < deadline)) {
+        order = best_order;
+        size_t from = position(planner_random);
+        size_t to = position(planner_random);
+        if (from == to) {
+            continue;
+        }
+        if (planner_random() % 2 == 0) {
+            std::swap(order[from], order[to]);
+        } else if (from < to) {
+            std::rotate(order.begin() + from, order.begin() + from + 1, order.begin() + to + 1);
+        } else {
+            std::rotate(order.begin() + to, order.begin() + from, order.begin() + from + 1);
+        }
+        // A plan ending after the best one is worse: it is dropped at its first job ending too late.
+        bool complete = plan_in_order(order, starts, current_time, best_score.makespan);
+        release_plan(order, starts);
+        nb_evaluated++;
+        PlanScore score = complete ? score_plan(order, starts) : best_score;
+        if (complete && better_plan(score, best_score)) {
+            best_score = score;
+            best_order.swap(order);
+            best_starts.swap(starts);
+            improved = true;
+            nb_failures = 0;
+        } else {
+            nb_failures++;
+        }
+    }
+
+    for (size_t i = 0; i < best_order.size(); ++i) {
+        SchedJob* job = best_order[i];
+        profile.reserve(best_starts[i], AvailabilityProfile::end_of(best_starts[i], job->walltime), job->nb_hosts);
+    }
+    if (improved) {
+        plan_changed = true;
+        std::vector<std::pair<double, double>> vacated;
+        for (size_t i = 0; i < best_order.size(); ++i) {
+            SchedJob* job = best_order[i];
+            if (std::abs(job->start_time - best_starts[i]) > TIME_EPSILON) {
+                vacated.emplace_back(job->start_time, AvailabilityProfile::end_of(job->start_time, job->walltime));
+            }
+            reservations.erase(job->reservation);
+            job->start_time = best_starts[i];
+            job->reservation = reservations.emplace(job->start_time, job);
+        }
+        for (const auto &window : vacated) {
+            add_freed_range(freed, window.first, window.second);
+        }
+    }
+    SCHED_DEBUG("Local search: %zu plans evaluated, makespan of the first %zu jobs %g%s\n", nb_evaluated,
+                best_order.size(), best_score.makespan, improved ? " (improved)" : "");
+    return nb_evaluated;
+}
+
+// Starts job now on the first nb_hosts available resources (its hosts are already
+// counted in the profile), returns its allocation.
+static const std::set<uint32_t> &start_job(SchedJob* job, double current_time) {
+    std::set<uint32_t> &job_resources = job_allocations[job->job_id];
+    job_resources.clear();
+    auto it = available_res.begin();
+    for (uint8_t i = 0; i < job->nb_hosts; ++i) {
+        job_resources.insert(*it);
+        it = available_res.erase(it);
+    }
+    // The profile keeps the planned window, even if the job starts up to TIME_EPSILON later.
+    job->start_time = std::min(job->start_time, current_time);
+    running_jobs[job->job_id] = job;
+    
+    // Build a comma-separated list of allocated resource IDs.
+    mb->add_execute_job(job->job_id, format_resources(job_resources));
+    online_metrics_job_started(job->job_id, current_time, job_resources);
+    return job_resources;
 }
 
 // -------------------------
@@ -135,11 +500,13 @@ extern "C" uint8_t batsim_edc_take_decisions(
     uint8_t **decisions,
     uint32_t *decisions_size)
 {
-    (void) what_happened_size;
+    DecisionTimer timer;
     auto *parsed = deserialize_message(*mb, !format_binary, what_happened);
     mb->clear(parsed->now());
+    timer.end_phase(PHASE_DESERIALIZE);
     
     double current_time = parsed->now();
+    FreedRanges freed;  // Time ranges given back by early completions
     
     auto nb_events = parsed->events()->size();
     for (unsigned int i = 0; i < nb_events; ++i) {
@@ -153,10 +520,13 @@ extern "C" uint8_t batsim_edc_take_decisions(
             case fb::Event_SimulationBeginsEvent: {
                 auto simu_begins = event->event_as_SimulationBeginsEvent();
                 platform_nb_hosts = simu_begins->computation_host_number();
+                online_metrics_simulation_begins(current_time, platform_nb_hosts);
                 
-                // Initialize available resources for time 0 (hosts are numbered from 0 to platform_nb_hosts-1)
-                ensure_time_slot_exists(0);
-                
+                // Initialize available resources (hosts are numbered from 0 to platform_nb_hosts-1)
+                for (uint32_t i = 0; i < platform_nb_hosts; i++) {
+                    available_res.insert(i);
+                }
+                profile.reset(platform_nb_hosts);
             } break;
             
             case fb::Event_JobSubmittedEvent: {
@@ -165,31 +535,40 @@ extern "C" uint8_t batsim_edc_take_decisions(
                 job->job_id = parsed_job->job_id()->str();
                 job->nb_hosts = parsed_job->job()->resource_request();
                 job->walltime = parsed_job->job()->walltime();  // Initialize walltime from the job
+                online_metrics_job_submitted(job->job_id, current_time);
                 
                 // Reject jobs that request more hosts than available on the platform
                 if (job->nb_hosts > platform_nb_hosts) {
                     mb->add_reject_job(job->job_id);
+                    online_metrics_job_rejected(job->job_id, current_time);
                     delete job;
                 } else {
-                    jobs->push_back(job);
+                    // Plan the job after every job already waiting: only its own reservation is added.
+                    job->submission_index = next_submission_index++;
+                    job->queue_position = jobs->insert(jobs->end(), job);
+                    plan_job(job, current_time);
                 }
             } break;
             
             case fb::Event_JobCompletedEvent: {
                 auto parsed_job = event->event_as_JobCompletedEvent();
                 std::string completed_job_id = parsed_job->job_id()->str();
+                online_metrics_job_completed(completed_job_id, current_time);
                 
                 // If the job is still running, free its resources
                 if (running_jobs.count(completed_job_id)) {
                     SchedJob* completed_job = running_jobs[completed_job_id];
+                    for (uint32_t host : job_allocations[completed_job_id]) {
+                        available_res.insert(host);
+                    }
                     
-                    // Free resources for all time slots from current time to the end of the job's walltime
-                    for (size_t t = static_cast<size_t>(current_time); t < available_res.size(); ++t) {
-                        // Add the resources back to the available set for this time slot
-                        for (uint32_t host : job_allocations[completed_job_id]) {
-                            available_res[t].insert(host);
-                        }
+                    // A job that finishes before its walltime gives back the rest of its reservation.
+                    double planned_end = AvailabilityProfile::end_of(completed_job->start_time, completed_job->walltime);
+                    if (current_time < planned_end - TIME_EPSILON) {
+                        profile.release(current_time, planned_end, completed_job->nb_hosts);
+                        add_freed_range(freed, current_time, planned_end);
                     }
+                    plan_changed = true;
                     
                     running_jobs.erase(completed_job_id);
                     job_allocations.erase(completed_job_id);
@@ -202,183 +581,76 @@ extern "C" uint8_t batsim_edc_take_decisions(
         }
     }
     
+    timer.end_phase(PHASE_EVENTS);
+    size_t queue_length = jobs->size();
+    size_t candidates_scanned = 0;
+
     // -------------------------
-    // Scheduling loop with backfilling
+    // Scheduling with reservations
     // -------------------------
-    size_t time_index = static_cast<size_t>(current_time);
-    
-    while (!jobs->empty()) {
-        // Always try to schedule the job at the front of the queue first.
-        SchedJob* job = jobs->front();
+    profile.forget_before(current_time);
+
+    if (local_search) {
+        candidates_scanned += improve_plan(freed, current_time);
+    }
+    if (!freed.empty()) {
+        // Hosts were freed earlier than planned: let the reservations that can use them move earlier.
+        size_t nb_checked = 0;
+        size_t nb_moved = compact_reservations(freed, current_time, nb_checked);
+        candidates_scanned += nb_checked;
+        SCHED_DEBUG("%zu of %zu reservations looked at, %zu moves\n", nb_checked, jobs->size(), nb_moved);
+        plan_changed = plan_changed || nb_moved > 0;
+    }
+
+    // Start the jobs whose reservation is due, in queue order so that the backfill
+    // counters only count jobs that overtake a job submitted before them.
+    std::vector<SchedJob*> due_jobs;
+    for (auto it = reservations.begin(); it != reservations.end() && it->first <= current_time + TIME_EPSILON; ++it) {
+        due_jobs.push_back(it->second);
+    }
+    std::sort(due_jobs.begin(), due_jobs.end(), [](const SchedJob* a, const SchedJob* b) {
+        return a->submission_index < b->submission_index;
+    });
+    for (SchedJob* job : due_jobs) {
+        candidates_scanned++;
+        if (available_res.size() < job->nb_hosts) {
+            // Only possible if a running job outlives its walltime: try again at the next event.
+            SCHED_WARNING("Job %s is due at %g but only %zu hosts are free\n",
+                          job->job_id.c_str(), current_time, available_res.size());
+            continue;
+        }
+        if (job->start_time < current_time - TIME_EPSILON && !catch_up(job, current_time)) {
+            continue;
+        }
+        reservations.erase(job->reservation);
+        jobs->erase(job->queue_position);
+        plan_changed = true;
+        const std::set<uint32_t> &job_resources = start_job(job, current_time);
         
-        if (available_res[time_index].size() >= job->nb_hosts) {
-            // The front job fits: allocate the first nb_hosts resources available.
-            
-            // Get the first nb_hosts resources from the available set
-            std::set<uint32_t> job_resources;
-            auto it = available_res[time_index].begin();
-            for (uint8_t i = 0; i < job->nb_hosts; ++i, ++it) {
-                job_resources.insert(*it);
-            }
-            
-            // Check if the same resources are available for the entire walltime
-            bool resources_available = true;
-            
-            // First, ensure all time slots exist
-            if(time_index + job->walltime > available_res.size()){
-                ensure_time_slot_exists(time_index + job->walltime);
-                
-            }
-            
-            // Then check if all required resources are available at each time slot
-
-            for (size_t t = time_index + 1; t < time_index + job->walltime; ++t) {
-                // Check if all required resources are available at this time slot
-                for (uint32_t res : job_resources) {
-                    if (available_res[t].find(res) == available_res[t].end()) {
-                        resources_available = false;
-                        break;
-                    }
-                }
-                
-                if (!resources_available) {
-                    break;
-                }
-            }
-            
-            if (resources_available) {
-                // Erase resources from all time slots that the job will occupy
-                for (size_t t = time_index; t < time_index + job->walltime; ++t) {
-                    // Erase the resources from this time slot
-                    for (uint32_t res : job_resources) {
-                        available_res[t].erase(res);
-                    }
-                }
-                
-                running_jobs[job->job_id] = job;
-                job_allocations[job->job_id] = job_resources;
-                
-                // Build a comma-separated list of allocated resource IDs.
-                std::string resources_str;
-                for (auto it = job_resources.begin(); it != job_resources.end(); ++it) {
-                    if (it != job_resources.begin())
-                        resources_str += ",";
-                    resources_str += std::to_string(*it);
-                }
-                mb->add_execute_job(job->job_id, resources_str);
-                
-                jobs->pop_front();
-                
-            } 
-        } else {
-            // The front job does not fit: attempt to backfill one job from the rest of the queue.
+        if (!jobs->empty() && jobs->front()->submission_index < job->submission_index) {
+            backfill_success_count++;
             
-            bool backfilled = false;
-            
-            for (auto job_it = std::next(jobs->begin()); job_it != jobs->end(); ++job_it) {
-                SchedJob* backfill_job = *job_it;
-                
-                if (available_res[time_index].size() >= backfill_job->nb_hosts) {
-                    
-                    std::set<uint32_t> assigned_resources = available_res[time_index];
-                    
-                    // Sort the assigned resources in ascending order (BASIC STEP)
-                    std::vector<uint32_t> sorted_resources(assigned_resources.begin(), assigned_resources.end());
-                    std::sort(sorted_resources.begin(), sorted_resources.end());
-                    assigned_resources = std::set<uint32_t>(sorted_resources.begin(), sorted_resources.end());
-                    
-                    uint32_t time = 0;
-                    
-                    // First, ensure all time slots exist
-                    if(time_index + backfill_job->walltime > available_res.size()){
-                        ensure_time_slot_exists(time_index + backfill_job->walltime);
-                    }
-                    
-                    //now add an iterator from time_index to the end of the available_res vector
-                    for (auto it = time_index; it < time_index + backfill_job->walltime; ++it) {
-                        
-                        // here we need to take the intersection of the assigned_resources and the available_res[it]
-                        std::set<uint32_t> intersection;
-                        std::set_intersection(assigned_resources.begin(), assigned_resources.end(), 
-                                             available_res[it].begin(), available_res[it].end(), 
-                                             std::inserter(intersection, intersection.begin()));
-                        
-                        assigned_resources = intersection;
-                        // update the time variable with the duration of the timeslice j
-                        time = time + (it - time_index); 
-                        // if we arrived at the end of the needed walltime, we can break the loop
-                        if (time >= backfill_job->walltime) {
-                            backfilled = true;
-                            break;
-                        }
-                    }
-                    
-                    if(assigned_resources.size() >= backfill_job->nb_hosts && backfilled) {
-                        backfill_success_count++;
-                        
-                        // Check if the allocated resources are contiguous
-                        bool is_contiguous = true;
-                        auto it_res = assigned_resources.begin();
-                        auto next = std::next(it_res);
-                        while (next != assigned_resources.end()) {
-                            if (*next - *it_res != 1) {
-                                is_contiguous = false;
-                                break;
-                            }
-                            ++it_res;
-                            ++next;
-                        }
-                        
-                        if (is_contiguous) {
-                            contiguous_backfill_count++;
-                        } else {
-                            non_contiguous_backfill_count++;
-                        }
-
-                        // Get only the first backfill_job->nb_hosts resources
-                        std::set<uint32_t> trimmed_resources(assigned_resources.begin(), std::next(assigned_resources.begin(), std::min(static_cast<size_t>(backfill_job->nb_hosts), assigned_resources.size())));
-                        job_allocations[backfill_job->job_id] = trimmed_resources;
-                        running_jobs[backfill_job->job_id] = backfill_job;
-
-                        // Erase resources from all time slots that the job will occupy
-                        for (size_t t = time_index; t < time_index + backfill_job->walltime; ++t) {
-                            // Erase the resources from this time slot
-                            for (uint32_t res : trimmed_resources) {
-                                available_res[t].erase(res);
-                            }
-                        }
-                        
-                        std::string resources_str;
-                        for (auto res_iter = trimmed_resources.begin(); res_iter != trimmed_resources.end(); ++res_iter) {
-                            if (res_iter != trimmed_resources.begin())
-                                resources_str += ",";
-                            resources_str += std::to_string(*res_iter);
-                        }
-                        mb->add_execute_job(backfill_job->job_id, resources_str);
-                        
-                        // Remove the backfilled job from the pending queue.
-                        jobs->erase(job_it);
-                        backfilled = true;
-                        break; // Schedule at most one backfilled job in this decision cycle.
-                    } 
-                }
-            }
-            
-            // If no pending job (other than the front) can be scheduled, then break out.
-            if (!backfilled) {
-                break;
+            // Check if the allocated resources are contiguous
+            if (job_resources.size() <= 1 || *job_resources.rbegin() - *job_resources.begin() + 1 == job_resources.size()) {
+                contiguous_backfill_count++;
             } else {
-                // (Optionally, you could continue the loop to check for more opportunities.)
-                break;
+                non_contiguous_backfill_count++;
             }
         }
     }
     
+    request_next_call(current_time);
+    
     log_message("%u %u %u\n", 
         backfill_success_count, contiguous_backfill_count, non_contiguous_backfill_count);
         
+    timer.end_phase(PHASE_SCHEDULING);
+
     mb->finish_message(parsed->now());
     serialize_message(*mb, !format_binary, const_cast<const uint8_t **>(decisions), decisions_size);
+    timer.end_phase(PHASE_SERIALIZE);
+    timer.finish(queue_length, candidates_scanned);
+    msg_trace_record(what_happened, what_happened_size, *decisions, *decisions_size);
     return 0;
 }
 
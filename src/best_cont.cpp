@@ -1,21 +1,38 @@
-// backfilling.cpp
+// best_cont.cpp
 //
-// A simple backfilling scheduler implementation for Batsim.
-// This implementation uses a list (jobs) for the pending jobs queue,
-// a set for available resources, and maps for running jobs and their allocations.
+// A best effort contiguous backfilling scheduler implementation for Batsim.
+// This implementation uses a list (jobs) for the pending jobs queue, in submission order,
+// a profile of the free hosts per one-second slot (slot_profile.hpp) for available resources,
+// and maps for running jobs and their allocations.
+// The front job starts on the first free hosts when they are free for its whole walltime.
+// Otherwise at most one later job is backfilled per decision call, among the hosts free over its
+// backfilling window (see backfill_window_hosts()): on contiguous ones if there are enough
+// (consecutive host ids, or the fewest switches with a "topology_file", see topology.hpp), else
+// on the first ones. The log counts the contiguous and non-contiguous backfills. Jobs larger
+// than the platform are rejected.
+// With "backfill_threads", the backfilling candidates are evaluated on a thread pool.
 
 #include <cstdint>
 #include <list>
 #include <set>
 #include <unordered_map>
+#include <vector>
 #include <string>
 #include <cstdio>
 #include <iterator>
 #include <sstream>
-#include <fstream>
 #include <batprotocol.hpp>
 #include <intervalset.hpp>
 #include "batsim_edc.h"
+#include "edc_config.hpp"
+#include "async_log.hpp"
+#include "decision_stats.hpp"
+#include "log_level.hpp"
+#include "online_metrics.hpp"
+#include "msg_trace.hpp"
+#include "slot_profile.hpp"
+#include "thread_pool.hpp"
+#include "topology.hpp"
 
 using namespace batprotocol;
 
@@ -32,36 +49,73 @@ static std::list<SchedJob*> *jobs = nullptr;
 static std::unordered_map<std::string, SchedJob*> running_jobs;
 static std::unordered_map<std::string, std::set<uint32_t>> job_allocations;
 static uint32_t platform_nb_hosts = 0;
-static std::vector<std::set<uint32_t>> available_res;
-static std::ofstream log_file;  // Log file stream
+static SlotProfile available_res;
 static uint32_t backfill_success_count = 0;
 static uint32_t contiguous_backfill_count = 0;
 static uint32_t non_contiguous_backfill_count = 0;
 
+// Backfilling candidates are evaluated by waves of backfill_wave_size, on backfill_pool if there is one
+static ThreadPool *backfill_pool = nullptr;
+static size_t backfill_wave_size = 1;
+static std::vector<std::list<SchedJob*>::iterator> backfill_wave;
+static std::vector<BackfillCandidate> backfill_candidates;
+
+// Switches of the hosts, from the initialization data (consecutive host ids without one)
+static Topology topology;
+
 
 // -------------------------
 // Initialization function
 // -------------------------
 extern "C" uint8_t batsim_edc_init(const uint8_t *data, uint32_t size, uint32_t flags) {
-    (void)data; // Unused
-    (void)size; // Unused
-
     format_binary = ((flags & BATSIM_EDC_FORMAT_BINARY) != 0);
     if ((flags & (BATSIM_EDC_FORMAT_BINARY | BATSIM_EDC_FORMAT_JSON)) != flags) {
         printf("Unknown flags used, cannot initialize backfilling scheduler.\n");
         return 1;
     }
     
+    EdcConfig config;
+    if (!parse_edc_config(data, size, config) || !log_level_init(config)) {
+        return 1;
+    }
+    if (!msg_trace_open(config, data, size, flags) || !topology_init(config, topology)) {
+        return 1;
+    }
+
+    // 1 evaluates the backfilling candidates in the calling thread, 0 uses one thread per core
+    double threads_value = config.get_number("backfill_threads", 1);
+    if (!(threads_value >= 0 && threads_value <= ThreadPool::max_threads())
+        || threads_value != static_cast<unsigned>(threads_value)) {
+        printf("Invalid backfill_threads %g (expected 0 for one per core, or 1 to %u)\n", threads_value,
+               ThreadPool::max_threads());
+        return 1;
+    }
+    unsigned backfill_threads = static_cast<unsigned>(threads_value);
+
     mb = new MessageBuilder(!format_binary);
     jobs = new std::list<SchedJob*>();
 
-    log_file.open("best_cont_log.txt", std::ios::out | std::ios::trunc);
-    if (!log_file.is_open()) {
+    if (backfill_threads != 1) {
+        backfill_pool = new ThreadPool(backfill_threads);
+        backfill_wave_size = 4 * backfill_pool->size();
+    } else {
+        backfill_wave_size = 1;
+    }
+
+    // The library may be initialized several times in the same process (e.g. by the sweep tool)
+    backfill_success_count = 0;
+    contiguous_backfill_count = 0;
+    non_contiguous_backfill_count = 0;
+
+    decision_stats_init(config, "best_cont");
+    online_metrics_init(config, "best_cont");
+
+    if (!async_log_open(config.get_string("log_file", "best_cont_log.txt"), log_level_enabled(LOG_LEVEL_DEBUG))) {
         printf("Warning: Could not open log file for writing\n");
     } else {
-        log_file << "EASY Backfilling Scheduler Log\n";
-        log_file << "FORMAT: <total_backfills> <contiguous_backfills> <non_contiguous_backfills>\n";
-        log_file << "=============================\n\n";
+        log_message("EASY Backfilling Scheduler Log\n");
+        log_message("FORMAT: <total_backfills> <contiguous_backfills> <non_contiguous_backfills>\n");
+        log_message("=============================\n\n");
     }
     
     
@@ -91,77 +145,31 @@ extern "C" uint8_t batsim_edc_deinit() {
     running_jobs.clear();
     job_allocations.clear();
     available_res.clear();
+    delete backfill_pool;
+    backfill_pool = nullptr;
+    backfill_wave.clear();
+    backfill_candidates.clear();
+    topology.clear();
 
-    // Close log file
- 
+    decision_stats_dump();
+    online_metrics_dump();
+    msg_trace_close();
 
-    if (log_file.is_open()) {
- 
-
-        log_file.close();
- 
-
-    }
+    async_log_close();
 
     
     return 0;
 }
 
-void log_message(const char* format, ...) {
-
-    char buffer[1024];
-
-    va_list args;
- 
-    va_start(args, format);
- 
-    vsnprintf(buffer, sizeof(buffer), format, args);
- 
-    va_end(args);
-
-    // Print to console
-
-    printf("%s", buffer);
-
-    // Write to log file if open
-
-    if (log_file.is_open()) {
-
-        log_file << buffer;
-
-        log_file.flush();  // Ensure it's written immediately
-    }
-}
-
-// Helper function to ensure available_res has enough time slots
-void ensure_time_slot_exists(double time) {
-    size_t time_index = static_cast<size_t>(time);
-    
-    // If the time slot doesn't exist yet, create it and all slots up to it
-    while (available_res.size() <= time_index) {
-        size_t new_index = available_res.size();
-        available_res.push_back(std::set<uint32_t>());
-        
-        // Add all platform resources to the new time slot
-        for (uint32_t i = 0; i < platform_nb_hosts; i++) {
-            available_res[new_index].insert(i);
-        }
-    }
-}
-
 // Helper function to execute a job
-void execute_job(SchedJob* job, const std::set<uint32_t>& resources) {
+void execute_job(SchedJob* job, const std::set<uint32_t>& resources, double now) {
     // Validate that we have resources to allocate
     if (resources.empty()) {
         return;
     }
     
-    std::string resources_str;
-    for (auto it = resources.begin(); it != resources.end(); ++it) {
-        if (it != resources.begin()) resources_str += ",";
-        resources_str += std::to_string(*it);
-    }
-    mb->add_execute_job(job->job_id, resources_str);
+    mb->add_execute_job(job->job_id, format_resources(resources));
+    online_metrics_job_started(job->job_id, now, resources);
     jobs->pop_front();
 }
 
@@ -174,9 +182,10 @@ extern "C" uint8_t batsim_edc_take_decisions(
     uint8_t **decisions,
     uint32_t *decisions_size)
 {
-    (void) what_happened_size;
+    DecisionTimer timer;
     auto *parsed = deserialize_message(*mb, !format_binary, what_happened);
     mb->clear(parsed->now());
+    timer.end_phase(PHASE_DESERIALIZE);
     
     double current_time = parsed->now();
     
@@ -192,9 +201,10 @@ extern "C" uint8_t batsim_edc_take_decisions(
             case fb::Event_SimulationBeginsEvent: {
                 auto simu_begins = event->event_as_SimulationBeginsEvent();
                 platform_nb_hosts = simu_begins->computation_host_number();
+                online_metrics_simulation_begins(current_time, platform_nb_hosts);
                 
                 // Initialize available resources for time 0 (hosts are numbered from 0 to platform_nb_hosts-1)
-                ensure_time_slot_exists(0);
+                ensure_time_slot_exists(available_res, 0, platform_nb_hosts);
                 
             } break;
             
@@ -204,10 +214,12 @@ extern "C" uint8_t batsim_edc_take_decisions(
                 job->job_id = parsed_job->job_id()->str();
                 job->nb_hosts = parsed_job->job()->resource_request();
                 job->walltime = parsed_job->job()->walltime();  // Initialize walltime from the job
+                online_metrics_job_submitted(job->job_id, current_time);
                 
                 // Reject jobs that request more hosts than available on the platform
                 if (job->nb_hosts > platform_nb_hosts) {
                     mb->add_reject_job(job->job_id);
+                    online_metrics_job_rejected(job->job_id, current_time);
                     delete job;
                 } else {
                     jobs->push_back(job);
@@ -217,18 +229,15 @@ extern "C" uint8_t batsim_edc_take_decisions(
             case fb::Event_JobCompletedEvent: {
                 auto parsed_job = event->event_as_JobCompletedEvent();
                 std::string completed_job_id = parsed_job->job_id()->str();
+                online_metrics_job_completed(completed_job_id, current_time);
                 
                 // If the job is still running, free its resources
                 if (running_jobs.count(completed_job_id)) {
                     SchedJob* completed_job = running_jobs[completed_job_id];
                     
                     // Free resources for all time slots from current time to the end of the job's walltime
-                    for (size_t t = static_cast<size_t>(current_time); t < available_res.size(); ++t) {
-                        // Add the resources back to the available set for this time slot
-                        for (uint32_t host : job_allocations[completed_job_id]) {
-                            available_res[t].insert(host);
-                        }
-                    }
+                    release_window(available_res, job_allocations[completed_job_id],
+                                   static_cast<size_t>(current_time), available_res.size());
                     
                     running_jobs.erase(completed_job_id);
                     job_allocations.erase(completed_job_id);
@@ -243,6 +252,10 @@ extern "C" uint8_t batsim_edc_take_decisions(
         }
     }
     
+    timer.end_phase(PHASE_EVENTS);
+    size_t queue_length = jobs->size();
+    size_t candidates_scanned = 0;
+
     // -------------------------
     // Scheduling loop with backfilling
     // -------------------------
@@ -252,6 +265,7 @@ extern "C" uint8_t batsim_edc_take_decisions(
     while (!jobs->empty()) {
         // Always try to schedule the job at the front of the queue first.
         SchedJob* job = jobs->front();
+        candidates_scanned++;
         
         if (available_res[time_index].size() >= job->nb_hosts) {
             // The front job fits: allocate the first nb_hosts resources available.
@@ -268,7 +282,7 @@ extern "C" uint8_t batsim_edc_take_decisions(
             
             // First, ensure all time slots exist
             if(time_index + job->walltime > available_res.size()){
-                ensure_time_slot_exists(time_index + job->walltime);
+                ensure_time_slot_exists(available_res, time_index + job->walltime, platform_nb_hosts);
             }
             
             // Then check if all required resources are available at each time slot
@@ -291,154 +305,124 @@ extern "C" uint8_t batsim_edc_take_decisions(
             
             if (resources_available) {
                 // Erase resources from all time slots that the job will occupy
-                for (size_t t = time_index; t < time_index + job->walltime; ++t) {
-                    // Erase the resources from this time slot
-                    for (uint32_t res : job_resources) {
-                        available_res[t].erase(res);
-                    }
-                }
+                reserve_window(available_res, job_resources, time_index, time_index + job->walltime);
                 
                 running_jobs[job->job_id] = job;
                 job_allocations[job->job_id] = job_resources;
                 
-                // Build a comma-separated list of allocated resource IDs.
-                std::string resources_str;
-                for (auto it = job_resources.begin(); it != job_resources.end(); ++it) {
-                    if (it != job_resources.begin())
-                        resources_str += ",";
-                    resources_str += std::to_string(*it);
-                }
-                execute_job(job, job_resources);
+                execute_job(job, job_resources, current_time);
                 
             }
         } else {
             // The front job does not fit: attempt to backfill one job from the rest of the queue.
-            
+            // The candidates are evaluated by waves, in parallel when there is a pool, against the
+            // profile, which nothing modifies until the wave is done. The wave is then walked in
+            // queue order to start the first candidate that can start, as a serial scan would.
             bool backfilled = false;
-            
-            for (auto it = std::next(jobs->begin()); it != jobs->end(); ++it) {
-                SchedJob* backfill_job = *it;
-                
-                if (available_res[time_index].size() >= backfill_job->nb_hosts) {
-                    
-                    std::set<uint32_t> assigned_resources = available_res[time_index];
-                    
-                    // Sort the assigned resources in ascending order (BASIC)
-                    std::vector<uint32_t> sorted_resources(assigned_resources.begin(), assigned_resources.end());
-                    std::sort(sorted_resources.begin(), sorted_resources.end());
-                    assigned_resources = std::set<uint32_t>(sorted_resources.begin(), sorted_resources.end());
-                    
-                    uint32_t time = 0;
-                    
-                    // First, ensure all time slots exist
-                    if(time_index + backfill_job->walltime > available_res.size()){
-                        ensure_time_slot_exists(time_index + backfill_job->walltime);
+            bool window_checked = false;  // Reached the walltime for this candidate or an earlier one
+            auto unevaluated = std::next(jobs->begin());
+            while (!backfilled && unevaluated != jobs->end()) {
+                backfill_wave.clear();
+                for (; unevaluated != jobs->end() && backfill_wave.size() < backfill_wave_size; ++unevaluated) {
+                    SchedJob* backfill_job = *unevaluated;
+                    backfill_wave.push_back(unevaluated);
+                    // The evaluation only reads the profile, so the time slots must exist beforehand
+                    if (available_res[time_index].size() >= backfill_job->nb_hosts
+                        && time_index + backfill_job->walltime > available_res.size()) {
+                        ensure_time_slot_exists(available_res, time_index + backfill_job->walltime, platform_nb_hosts);
                     }
-                    
-                    
-                    //now add an iterator from time_index to the end of the available_res vector
-                    for (auto it = time_index; it < time_index + backfill_job->walltime; ++it) {
-                        
-                        // here we need to take the intersection of the assigned_resources and the available_res[it]
-                        std::set<uint32_t> intersection;
-                        std::set_intersection(assigned_resources.begin(), assigned_resources.end(), 
-                                             available_res[it].begin(), available_res[it].end(), 
-                                             std::inserter(intersection, intersection.begin()));
-                        
-                        assigned_resources = intersection;
-                        // update the time variable with the duration of the timeslice j
-                        time = time + (it - time_index); //?????
-                        // if we arrived at the end of the needed walltime, we can break the loop
-                        if (time >= backfill_job->walltime) {
-                            backfilled = true;
-                            break;
-                        }
+                }
+                backfill_candidates.resize(backfill_wave.size());
+                auto evaluate = [time_index](size_t i) {
+                    SchedJob* backfill_job = *backfill_wave[i];
+                    BackfillCandidate &candidate = backfill_candidates[i];
+                    evaluate_backfill_candidate(available_res, time_index, backfill_job->nb_hosts,
+                                                backfill_job->walltime, candidate);
+                    if (candidate.fits_now) {
+                        topology.find_contiguous(candidate.hosts, backfill_job->nb_hosts, candidate.run);
                     }
-                    
-                    if(assigned_resources.size() >= backfill_job->nb_hosts && backfilled) {
-
-                        // Find contiguous resources
-                        std::vector<uint32_t> best_effort_contiguous_resources;
-                        for (auto it = assigned_resources.begin(); it != assigned_resources.end(); ++it) {
-                            if (best_effort_contiguous_resources.empty() || *it == best_effort_contiguous_resources.back() + 1) {
-                                best_effort_contiguous_resources.push_back(*it);
-                            } else {
-                                best_effort_contiguous_resources.clear();
-                            }
-                            if (best_effort_contiguous_resources.size() == backfill_job->nb_hosts) {
-                                break;
-                            }
-                        }
-                        
-                        // Check if we found enough contiguous resources
-                        if (best_effort_contiguous_resources.size() < backfill_job->nb_hosts) {
-                            // If we don't have enough contiguous resources, just take the first nb_hosts resources
-                            best_effort_contiguous_resources.clear();
-
-                            auto it = assigned_resources.begin();
-                            for (uint8_t i = 0; i < backfill_job->nb_hosts && it != assigned_resources.end(); ++i, ++it) {
-                                best_effort_contiguous_resources.push_back(*it);
-                            }
-                            
-                            non_contiguous_backfill_count++;
-                        } else {
-                            contiguous_backfill_count++;
-                        }
-                        
-                        // Use the non-contiguous resources instead
-                        std::set<uint32_t> trimmed_resources(best_effort_contiguous_resources.begin(), best_effort_contiguous_resources.end());
-                        
-                        job_allocations[backfill_job->job_id] = trimmed_resources;
-                        running_jobs[backfill_job->job_id] = backfill_job;
-                        backfill_success_count++;
-                        
-                        // Build resource string and execute job
-                        std::string resources_str;
-                        for (auto res_iter = trimmed_resources.begin(); res_iter != trimmed_resources.end(); ++res_iter) {
-                            if (res_iter != trimmed_resources.begin())
-                                resources_str += ",";
-                            resources_str += std::to_string(*res_iter);
-                        }
-                        
-                        // Only execute if we have a valid resource string
-                        if (!resources_str.empty()) {
-                            mb->add_execute_job(backfill_job->job_id, resources_str);
-                        } else {
-                            continue;
-                        }
-                        
-                        // Erase resources from all time slots that the job will occupy
-                        for (size_t t = time_index; t < time_index + backfill_job->walltime; ++t) {
-                            // Erase the resources from this time slot
-                            for (uint32_t res : trimmed_resources) {
-                                available_res[t].erase(res);
-                            }
+                };
+                if (backfill_pool != nullptr) {
+                    backfill_pool->parallel_for(backfill_wave.size(), evaluate);
+                } else {
+                    for (size_t i = 0; i < backfill_wave.size(); ++i) {
+                        evaluate(i);
+                    }
+                }
+
+                for (size_t i = 0; i < backfill_wave.size(); ++i) {
+                    auto it = backfill_wave[i];
+                    SchedJob* backfill_job = *it;
+                    const BackfillCandidate &candidate = backfill_candidates[i];
+                    candidates_scanned++;
+                    if (!candidate.fits_now) {
+                        continue;
+                    }
+                    window_checked = window_checked || candidate.window_checked;
+                    if (candidate.hosts.size() < backfill_job->nb_hosts || !window_checked) {
+                        continue;
+                    }
+
+                    std::vector<uint32_t> best_effort_contiguous_resources = candidate.run;
+                    // Check if we found enough contiguous resources
+                    if (best_effort_contiguous_resources.size() < backfill_job->nb_hosts) {
+                        // If we don't have enough contiguous resources, just take the first nb_hosts resources
+                        best_effort_contiguous_resources.clear();
+
+                        auto host = candidate.hosts.begin();
+                        for (uint8_t h = 0; h < backfill_job->nb_hosts && host != candidate.hosts.end(); ++h, ++host) {
+                            best_effort_contiguous_resources.push_back(*host);
                         }
-                        
-                        // Remove the backfilled job from the pending queue.
-                        jobs->erase(it);
-                        backfilled = true;
-                        
-                        break; // Schedule at most one backfilled job in this decision cycle.
+
+                        non_contiguous_backfill_count++;
+                    } else {
+                        contiguous_backfill_count++;
+                    }
+
+                    // Use the non-contiguous resources instead
+                    std::set<uint32_t> trimmed_resources(best_effort_contiguous_resources.begin(), best_effort_contiguous_resources.end());
+
+                    job_allocations[backfill_job->job_id] = trimmed_resources;
+                    running_jobs[backfill_job->job_id] = backfill_job;
+                    backfill_success_count++;
+
+                    // Build resource string and execute job
+                    std::string resources_str = format_resources(trimmed_resources);
+
+                    // Only execute if we have a valid resource string
+                    if (!resources_str.empty()) {
+                        mb->add_execute_job(backfill_job->job_id, resources_str);
+                        online_metrics_job_started(backfill_job->job_id, current_time, trimmed_resources);
+                    } else {
+                        continue;
                     }
+
+                    // Erase resources from all time slots that the job will occupy
+                    reserve_window(available_res, trimmed_resources, time_index, time_index + backfill_job->walltime);
+
+                    // Remove the backfilled job from the pending queue.
+                    jobs->erase(it);
+                    backfilled = true;
+
+                    break; // Schedule at most one backfilled job in this decision cycle.
                 }
             }
-            
-            // If no pending job (other than the front) can be scheduled, then break out.
-            if (!backfilled) {
-                break;
-            } else {
-                // (Optionally, you could continue the loop to check for more opportunities.)
-                break;
-            }
+
+            // Whether a pending job (other than the front) was backfilled or not, stop here.
+            break;
         }
     }
     
     log_message("%u %u %u\n", 
            backfill_success_count, contiguous_backfill_count, non_contiguous_backfill_count);
     
+    timer.end_phase(PHASE_SCHEDULING);
+
     mb->finish_message(parsed->now());
     serialize_message(*mb, !format_binary, const_cast<const uint8_t **>(decisions), decisions_size);
+    timer.end_phase(PHASE_SERIALIZE);
+    timer.finish(queue_length, candidates_scanned);
+    msg_trace_record(what_happened, what_happened_size, *decisions, *decisions_size);
     return 0;
 }
 
@@ -0,0 +1,215 @@
+// decision_stats.cpp
+//
+// Storage and JSON report of the per-decision instrumentation, see decision_stats.hpp.
+
+#include "decision_stats.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "log_histogram.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+const char *phase_names[PHASE_COUNT] = {"deserialize", "events", "scheduling", "serialize"};
+
+// Decision latency as a function of the queue length, queue lengths being grouped by powers of two.
+const unsigned NB_QUEUE_CLASSES = 33;
+
+struct QueueClass {
+    uint64_t calls = 0;
+    double total_ns = 0;
+    uint64_t max_ns = 0;
+};
+
+struct DecisionStats {
+    std::string scheduler;
+    std::string output_path;
+    LogHistogram phases[PHASE_COUNT];
+    LogHistogram total;
+    LogHistogram queue_length;
+    LogHistogram candidates_scanned;
+    QueueClass by_queue_length[NB_QUEUE_CLASSES];
+    // Hardware counter totals per phase, and the number of calls they cover.
+    uint64_t counters[PHASE_COUNT][PERF_COUNTER_COUNT] = {};
+    uint64_t counted_calls = 0;
+    bool perf_requested = false;
+};
+
+bool enabled = false;
+std::unique_ptr<DecisionStats> stats;
+
+unsigned queue_class(size_t queue_length) {
+    if (queue_length == 0) {
+        return 0;
+    }
+    unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(queue_length));
+    return std::min(msb + 1, NB_QUEUE_CLASSES - 1);
+}
+
+json histogram_to_json(const LogHistogram &histogram) {
+    json buckets = json::array();
+    for (unsigned i = 0; i < histogram.nb_buckets(); ++i) {
+        if (histogram.bucket_count(i) > 0) {
+            buckets.push_back({LogHistogram::bucket_lower_bound(i), histogram.bucket_count(i)});
+        }
+    }
+    return json{
+        {"count", histogram.count()},
+        {"min", histogram.min()},
+        {"mean", histogram.mean()},
+        {"p50", histogram.quantile(0.5)},
+        {"p90", histogram.quantile(0.9)},
+        {"p99", histogram.quantile(0.99)},
+        {"p999", histogram.quantile(0.999)},
+        {"max", histogram.max()},
+        {"buckets", buckets} // [lower bound, count] of the non-empty buckets
+    };
+}
+
+json counters_to_json(const uint64_t counters[PERF_COUNTER_COUNT], uint64_t calls) {
+    json result;
+    for (int counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+        if (perf_counter_available(static_cast<PerfCounter>(counter))) {
+            result[perf_counter_name(static_cast<PerfCounter>(counter))] = counters[counter];
+            result[std::string(perf_counter_name(static_cast<PerfCounter>(counter))) + "_per_call"] =
+                calls == 0 ? 0.0 : static_cast<double>(counters[counter]) / static_cast<double>(calls);
+        }
+    }
+    // Derived ratios, only when both sides were measured.
+    double instructions = static_cast<double>(counters[PERF_INSTRUCTIONS]);
+    if (perf_counter_available(PERF_CYCLES) && perf_counter_available(PERF_INSTRUCTIONS) && counters[PERF_CYCLES] > 0) {
+        result["ipc"] = instructions / static_cast<double>(counters[PERF_CYCLES]);
+    }
+    if (perf_counter_available(PERF_INSTRUCTIONS) && counters[PERF_INSTRUCTIONS] > 0) {
+        if (perf_counter_available(PERF_LLC_MISSES)) {
+            result["llc_misses_per_kilo_instruction"] = 1000.0 * static_cast<double>(counters[PERF_LLC_MISSES]) / instructions;
+        }
+        if (perf_counter_available(PERF_BRANCH_MISSES)) {
+            result["branch_misses_per_kilo_instruction"] = 1000.0 * static_cast<double>(counters[PERF_BRANCH_MISSES]) / instructions;
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+void decision_stats_init(const EdcConfig &config, const char *scheduler_name) {
+    // Off by default, so that a run does not leave a file in the working directory it was not asked for.
+    enabled = config.get_bool("decision_stats", config.has("decision_stats_file") || config.get_bool("perf_counters", false));
+    stats.reset();
+    if (!enabled) {
+        if (config.get_bool("perf_counters", false)) {
+            printf("Warning: perf counters are part of the decision statistics, which are disabled\n");
+        }
+        return;
+    }
+    stats = std::make_unique<DecisionStats>();
+    stats->scheduler = scheduler_name;
+    stats->output_path = config.get_string("decision_stats_file", std::string(scheduler_name) + "_decision_stats.json");
+
+    perf_counters_close();
+    stats->perf_requested = config.get_bool("perf_counters", false);
+    if (stats->perf_requested && !perf_counters_open()) {
+        printf("Warning: perf counters unavailable, only timings will be recorded\n");
+    }
+}
+
+bool decision_stats_enabled() {
+    return enabled;
+}
+
+void decision_stats_record(const uint64_t phase_ns[PHASE_COUNT], const uint64_t (*phase_counters)[PERF_COUNTER_COUNT],
+                           size_t queue_length, size_t candidates_scanned) {
+    uint64_t total_ns = 0;
+    for (unsigned phase = 0; phase < PHASE_COUNT; ++phase) {
+        stats->phases[phase].record(phase_ns[phase]);
+        total_ns += phase_ns[phase];
+    }
+    stats->total.record(total_ns);
+    stats->queue_length.record(queue_length);
+    stats->candidates_scanned.record(candidates_scanned);
+
+    QueueClass &klass = stats->by_queue_length[queue_class(queue_length)];
+    klass.calls++;
+    klass.total_ns += static_cast<double>(total_ns);
+    klass.max_ns = std::max(klass.max_ns, total_ns);
+
+    if (phase_counters != nullptr) {
+        for (unsigned phase = 0; phase < PHASE_COUNT; ++phase) {
+            for (int counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+                stats->counters[phase][counter] += phase_counters[phase][counter];
+            }
+        }
+        stats->counted_calls++;
+    }
+}
+
+bool decision_stats_dump() {
+    if (!enabled || stats == nullptr) {
+        return true;
+    }
+
+    json report;
+    report["scheduler"] = stats->scheduler;
+    report["calls"] = stats->total.count();
+    report["unit"] = "ns";
+    for (unsigned phase = 0; phase < PHASE_COUNT; ++phase) {
+        report["phases"][phase_names[phase]] = histogram_to_json(stats->phases[phase]);
+    }
+    report["phases"]["total"] = histogram_to_json(stats->total);
+    report["queue_length"] = histogram_to_json(stats->queue_length);
+    report["candidates_scanned"] = histogram_to_json(stats->candidates_scanned);
+
+    json by_queue_length = json::array();
+    for (unsigned i = 0; i < NB_QUEUE_CLASSES; ++i) {
+        const QueueClass &klass = stats->by_queue_length[i];
+        if (klass.calls == 0) {
+            continue;
+        }
+        uint64_t low = (i == 0) ? 0 : (uint64_t(1) << (i - 1));
+        uint64_t high = (i == 0) ? 0 : (uint64_t(1) << i) - 1;
+        by_queue_length.push_back({
+            {"queue_length_min", low},
+            {"queue_length_max", high},
+            {"calls", klass.calls},
+            {"mean_ns", klass.total_ns / static_cast<double>(klass.calls)},
+            {"max_ns", klass.max_ns}});
+    }
+    report["total_by_queue_length"] = by_queue_length;
+
+    if (stats->perf_requested) {
+        json perf;
+        perf["available"] = perf_counters_enabled();
+        perf["calls"] = stats->counted_calls;
+        if (perf_counters_enabled()) {
+            uint64_t totals[PERF_COUNTER_COUNT] = {0, 0, 0, 0};
+            for (unsigned phase = 0; phase < PHASE_COUNT; ++phase) {
+                perf["phases"][phase_names[phase]] = counters_to_json(stats->counters[phase], stats->counted_calls);
+                for (int counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+                    totals[counter] += stats->counters[phase][counter];
+                }
+            }
+            perf["phases"]["total"] = counters_to_json(totals, stats->counted_calls);
+        }
+        report["perf_counters"] = perf;
+    }
+    perf_counters_close();
+
+    std::ofstream output(stats->output_path, std::ios::out | std::ios::trunc);
+    stats.reset();
+    enabled = false;
+    if (!output.is_open()) {
+        printf("Warning: Could not write the decision statistics\n");
+        return false;
+    }
+    output << report.dump(2) << "\n";
+    return true;
+}
@@ -0,0 +1,93 @@
+// decision_stats.hpp
+//
+// Per-decision instrumentation shared by all the schedulers.
+// Every batsim_edc_take_decisions() call is timed phase by phase into high-dynamic-range
+// histograms, together with the queue length and the number of candidate jobs scanned.
+// Everything is dumped as JSON by decision_stats_dump(), called from batsim_edc_deinit().
+//
+// Recording costs a few steady_clock reads and histogram increments per call. It is off by default
+// (it writes a file), and on as soon as an output file or the hardware counters are asked for.
+// Hardware counters (cycles, instructions, LLC misses, branch misses) can be added per phase;
+// they cost a read() syscall per phase and are off by default.
+// Init data keys:
+//   "decision_stats": true | false    enables the instrumentation
+//   "decision_stats_file": "<path>"   output file (enables it), "<scheduler>_decision_stats.json" by default
+//   "perf_counters": true             also collects hardware counters (enables it, see perf_counters.hpp)
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "edc_config.hpp"
+#include "perf_counters.hpp"
+
+enum DecisionPhase {
+    PHASE_DESERIALIZE = 0, // deserialize_message() and mb->clear()
+    PHASE_EVENTS,          // traversal of the received events
+    PHASE_SCHEDULING,      // scheduling loop
+    PHASE_SERIALIZE,       // finish_message() and serialize_message()
+    PHASE_COUNT
+};
+
+// Call once from batsim_edc_init(); resets everything recorded by a previous initialization.
+void decision_stats_init(const EdcConfig &config, const char *scheduler_name);
+
+// Writes the JSON report (if enabled) and releases the recorded data. Call from batsim_edc_deinit().
+bool decision_stats_dump();
+
+bool decision_stats_enabled();
+
+// Records one complete decision call. phase_counters is null when hardware counters are off.
+void decision_stats_record(const uint64_t phase_ns[PHASE_COUNT], const uint64_t (*phase_counters)[PERF_COUNTER_COUNT],
+                           size_t queue_length, size_t candidates_scanned);
+
+// Measures one batsim_edc_take_decisions() call. Create it first thing in the call,
+// call end_phase() at the end of each phase, and finish() right before returning.
+class DecisionTimer {
+public:
+    DecisionTimer() : enabled_(decision_stats_enabled()), counting_(enabled_ && perf_counters_enabled()) {
+        if (counting_) {
+            counting_ = perf_counters_read(counters_last_);
+        }
+        if (enabled_) {
+            last_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    void end_phase(DecisionPhase phase) {
+        if (enabled_) {
+            auto now = std::chrono::steady_clock::now();
+            phase_ns_[phase] += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_).count());
+            if (counting_) {
+                uint64_t counters[PERF_COUNTER_COUNT];
+                // A call with a failed read is recorded without counters (see finish()).
+                counting_ = perf_counters_read(counters);
+                for (int counter = 0; counting_ && counter < PERF_COUNTER_COUNT; ++counter) {
+                    // Multiplexing scales the values, which may then go back a little: count nothing.
+                    if (counters[counter] > counters_last_[counter]) {
+                        phase_counters_[phase][counter] += counters[counter] - counters_last_[counter];
+                        counters_last_[counter] = counters[counter];
+                    }
+                }
+                now = std::chrono::steady_clock::now(); // do not charge the read() to the next phase
+            }
+            last_ = now;
+        }
+    }
+
+    void finish(size_t queue_length, size_t candidates_scanned) {
+        if (enabled_) {
+            decision_stats_record(phase_ns_, counting_ ? phase_counters_ : nullptr, queue_length, candidates_scanned);
+        }
+    }
+
+private:
+    bool enabled_;
+    bool counting_;
+    std::chrono::steady_clock::time_point last_;
+    uint64_t phase_ns_[PHASE_COUNT] = {0, 0, 0, 0};
+    uint64_t counters_last_[PERF_COUNTER_COUNT] = {0, 0, 0, 0};
+    uint64_t phase_counters_[PHASE_COUNT][PERF_COUNTER_COUNT] = {};
+};
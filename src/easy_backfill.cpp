@@ -1,65 +1,139 @@
-// backfilling.cpp
+// easy_backfill.cpp
 //
-// A simple backfilling scheduler implementation for Batsim.
-// This implementation uses a list (jobs) for the pending jobs queue,
+// An EASY backfilling scheduler implementation for Batsim.
+// This implementation uses an indexed heap (jobs) for the pending jobs queue, ordered by the
+// "priority" of the initialization data (submission order by default, see job_priority.hpp),
 // a set for available resources, and maps for running jobs and their allocations.
+// Running jobs are also indexed by their expected end (start + walltime): when the head job
+// does not fit, its shadow time (when enough hosts will be free for it) and extra nodes (hosts
+// free at the shadow time that it does not need) are read from this index, and a later job is
+// only backfilled if it ends before the shadow time or fits in the extra nodes, so the head job
+// is never delayed.
+// With "backfill": "lookahead" in the initialization data, the jobs to backfill are chosen by a
+// dynamic program over the first waiting jobs instead of first-fit (see backfill_lookahead()).
+// With "walltime_prediction": "history", expected ends and backfilling windows use predicted run
+// times instead of the walltimes (see walltime_predictor.hpp), which backfills more but may delay
+// the head job when a prediction is too short.
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
-#include <list>
+#include <limits>
+#include <map>
 #include <set>
 #include <unordered_map>
 #include <string>
 #include <cstdio>
 #include <iterator>
 #include <sstream>
-#include <fstream>
+#include <vector>
 #include <batprotocol.hpp>
 #include <intervalset.hpp>
 #include "batsim_edc.h"
+#include "edc_config.hpp"
+#include "async_log.hpp"
+#include "decision_stats.hpp"
+#include "indexed_heap.hpp"
+#include "job_priority.hpp"
+#include "log_level.hpp"
+#include "online_metrics.hpp"
+#include "msg_trace.hpp"
+#include "slot_profile.hpp"
+#include "walltime_predictor.hpp"
 
 using namespace batprotocol;
 
+struct SchedJob;
+typedef std::multimap<double, SchedJob*> EndIndex;
+
 struct SchedJob {
     std::string job_id;
     uint8_t nb_hosts;
+    double walltime;  // <= 0 if the workload gives none
+    double planned_walltime;  // Predicted run time, the walltime without prediction, see planned_walltime()
+    uint64_t predicted_after; // walltime_predictor_nb_observed() when it was predicted
+    std::string profile_id;
+    double submission_time;
+    double start_time;
+    uint64_t submission_index;
+    EndIndex::iterator expected_end;  // Entry in running_ends while the job runs
 };
+typedef IndexedHeap<SchedJob*, PriorityKey> JobQueue;
 
 // Global variables for scheduler state
 static MessageBuilder *mb = nullptr;
 static bool format_binary = true;
-static std::list<SchedJob*> *jobs = nullptr;
+static JobQueue *jobs = nullptr;
+static JobPriority priority = PRIORITY_FCFS;
+static double keys_time = -1;  // Time the keys of the waiting jobs were computed at
+static double priority_refresh = 60;  // Seconds between two recomputations of scores that change with time
+static uint64_t next_submission_index = 0;
 static std::unordered_map<std::string, SchedJob*> running_jobs;
 static std::unordered_map<std::string, std::set<uint32_t>> job_allocations;
 static uint32_t platform_nb_hosts = 0;
 static std::set<uint32_t> available_res;
+static EndIndex running_ends;  // Running jobs by expected end, jobs without walltime last
 static uint32_t backfill_success_count = 0;
 static uint32_t contiguous_backfill_count = 0;
 static uint32_t non_contiguous_backfill_count = 0;
-static std::ofstream log_file;
+
+// Lookahead backfilling, from the initialization data
+static bool lookahead_backfill = false;
+static size_t lookahead_depth = 50;       // Waiting jobs the dynamic program chooses from
+static double lookahead_budget_ms = 1;    // Time it may take per decision call
+static const size_t LOOKAHEAD_MAX_CELLS = 1 << 22;  // Bounds its table (one byte per cell)
+static std::vector<double> lookahead_best;    // Its tables, kept from call to call
+static std::vector<uint8_t> lookahead_taken;
 
 // -------------------------
 // Initialization function
 // -------------------------
 extern "C" uint8_t batsim_edc_init(const uint8_t *data, uint32_t size, uint32_t flags) {
-    (void)data; // Unused
-    (void)size; // Unused
-
     format_binary = ((flags & BATSIM_EDC_FORMAT_BINARY) != 0);
     if ((flags & (BATSIM_EDC_FORMAT_BINARY | BATSIM_EDC_FORMAT_JSON)) != flags) {
         printf("Unknown flags used, cannot initialize backfilling scheduler.\n");
         return 1;
     }
     
+    EdcConfig config;
+    if (!parse_edc_config(data, size, config) || !log_level_init(config)) {
+        return 1;
+    }
+    if (!msg_trace_open(config, data, size, flags) || !job_priority_init(config, priority)) {
+        return 1;
+    }
+    if (!walltime_predictor_init(config)) {
+        return 1;
+    }
+    std::string backfill_mode = config.get_string("backfill", "first_fit");
+    if (backfill_mode != "first_fit" && backfill_mode != "lookahead") {
+        printf("Unknown backfill mode '%s' (expected first_fit or lookahead)\n", backfill_mode.c_str());
+        return 1;
+    }
+    lookahead_backfill = (backfill_mode == "lookahead");
+    lookahead_depth = static_cast<size_t>(std::max(1.0, config.get_number("lookahead_depth", 50)));
+    lookahead_budget_ms = config.get_number("lookahead_budget_ms", 1);
+    priority_refresh = std::max(0.0, config.get_number("priority_refresh", 60));
+
     mb = new MessageBuilder(!format_binary);
-    jobs = new std::list<SchedJob*>();
+    jobs = new JobQueue();
 
-    log_file.open("easy_backfill_log.txt", std::ios::out | std::ios::trunc);
-    if (!log_file.is_open()) {
+    // The library may be initialized several times in the same process (e.g. by the sweep tool)
+    keys_time = -1;
+    next_submission_index = 0;
+    backfill_success_count = 0;
+    contiguous_backfill_count = 0;
+    non_contiguous_backfill_count = 0;
+
+    decision_stats_init(config, "easy_backfill");
+    online_metrics_init(config, "easy_backfill");
+
+    if (!async_log_open(config.get_string("log_file", "easy_backfill_log.txt"), log_level_enabled(LOG_LEVEL_DEBUG))) {
         printf("Warning: Could not open log file for writing\n");
     } else {
-        log_file << "EASY Backfilling Scheduler Log\n";
-        log_file << "FORMAT: <total_backfills> <contiguous_backfills> <non_contiguous_backfills>\n";
-        log_file << "=============================\n\n";
+        log_message("EASY Backfilling Scheduler Log\n");
+        log_message("FORMAT: <total_backfills> <contiguous_backfills> <non_contiguous_backfills>\n");
+        log_message("=============================\n\n");
     }
     
     
@@ -74,9 +148,10 @@ extern "C" uint8_t batsim_edc_deinit() {
     mb = nullptr;
     
     if (jobs != nullptr) {
-        for (auto *job : *jobs) {
+        jobs->visit_in_order([](JobQueue::Handle, SchedJob* job) {
             delete job;
-        }
+            return true;
+        });
         delete jobs;
         jobs = nullptr;
     }
@@ -88,44 +163,206 @@ extern "C" uint8_t batsim_edc_deinit() {
     running_jobs.clear();
     job_allocations.clear();
     available_res.clear();
+    running_ends.clear();
+    std::vector<double>().swap(lookahead_best);
+    std::vector<uint8_t>().swap(lookahead_taken);
 
-    // Close log file
- 
+    decision_stats_dump();
+    online_metrics_dump();
+    msg_trace_close();
 
-    if (log_file.is_open()) {
- 
-
-        log_file.close();
- 
-
-    }
+    async_log_close();
     
     return 0;
 }
-void log_message(const char* format, ...) {
 
-    char buffer[1024];
+// -------------------------
+// Starts job now on the first nb_hosts available resources, returns its allocation
+// -------------------------
+// Predicted run time of a waiting job, predicted again if jobs completed since the last prediction
+// -------------------------
+static double planned_walltime(SchedJob* job) {
+    uint64_t nb_observed = walltime_predictor_nb_observed();
+    if (job->predicted_after != nb_observed) {
+        job->planned_walltime = walltime_predictor_predict(job->job_id, job->profile_id, job->nb_hosts, job->walltime);
+        job->predicted_after = nb_observed;
+    }
+    return job->planned_walltime;
+}
 
-    va_list args;
- 
-    va_start(args, format);
- 
-    vsnprintf(buffer, sizeof(buffer), format, args);
- 
-    va_end(args);
+// -------------------------
+static const std::set<uint32_t> &start_job(SchedJob* job, double current_time) {
+    std::set<uint32_t> &job_resources = job_allocations[job->job_id];
+    job_resources.clear();
+    auto it = available_res.begin();
+    for (uint8_t i = 0; i < job->nb_hosts; ++i) {
+        job_resources.insert(*it);
+        it = available_res.erase(it);
+    }
+    running_jobs[job->job_id] = job;
+    job->start_time = current_time;
+    double predicted = planned_walltime(job);
+    double expected_end = (predicted > 0) ? current_time + predicted : std::numeric_limits<double>::infinity();
+    job->expected_end = running_ends.emplace(expected_end, job);
+
+    // Build a comma-separated list of allocated resource IDs.
+    mb->add_execute_job(job->job_id, format_resources(job_resources));
+    online_metrics_job_started(job->job_id, current_time, job_resources);
+    return job_resources;
+}
+
+// -------------------------
+// Gives back their walltime to the running jobs that outlived their predicted run time
+// -------------------------
+// They may run until their walltime, where they are killed, so the shadow time of the head job
+// must not count on their hosts before that.
+static void extend_overrun_predictions(double current_time) {
+    std::vector<SchedJob*> overrun;
+    for (auto it = running_ends.begin(); it != running_ends.end() && it->first <= current_time; ++it) {
+        if (it->second->planned_walltime != it->second->walltime) {
+            overrun.push_back(it->second);
+        }
+    }
+    for (SchedJob* job : overrun) {
+        SCHED_DEBUG("Job %s outlived its predicted run time of %g s\n", job->job_id.c_str(), job->planned_walltime);
+        running_ends.erase(job->expected_end);
+        job->planned_walltime = job->walltime;
+        double expected_end = (job->walltime > 0) ? job->start_time + job->walltime : std::numeric_limits<double>::infinity();
+        job->expected_end = running_ends.emplace(expected_end, job);
+    }
+}
 
-    // Print to console
+// -------------------------
+// Heap key of a waiting job at time now
+// -------------------------
+static PriorityKey priority_key(const SchedJob* job, double now) {
+    return job_priority_key(priority, job->submission_time, job->walltime, job->nb_hosts, job->submission_index, now);
+}
 
-    printf("%s", buffer);
+// -------------------------
+// Starts a backfilled job and counts it in the backfill counters
+// -------------------------
+static void start_backfilled_job(SchedJob* job, double current_time) {
+    const std::set<uint32_t> &job_resources = start_job(job, current_time);
+    backfill_success_count++;
+    if (job_resources.size() <= 1 || *job_resources.rbegin() - *job_resources.begin() + 1 == job_resources.size()) {
+        contiguous_backfill_count++;
+    } else {
+        non_contiguous_backfill_count++;
+    }
+}
 
-    // Write to log file if open
+// -------------------------
+// Lookahead backfilling (LOS, Shmueli & Feitelson)
+// -------------------------
+// First-fit backfilling takes the first candidates that fit, which may leave hosts idle that
+// another combination of jobs would use. This chooses, among the first lookahead_depth waiting jobs
+// after the head job, the set that fills the most node-seconds before the shadow time (the most
+// hosts if the head job has no shadow time). It is a knapsack with two capacities: the hosts free
+// now, used by every chosen job, and the extra nodes, also used by the jobs still running at the
+// shadow time, so the head job is not delayed either.
+// The dynamic program adds the candidates one by one: when the time budget runs out, it keeps the
+// best set among the candidates added so far, and the first-fit pass that follows looks at the
+// others. Ties go to the jobs ahead in the queue.
+// Returns the number of waiting jobs looked at.
+static size_t backfill_lookahead(double current_time, double shadow_time, uint32_t &extra_nodes) {
+    struct Candidate {
+        JobQueue::Handle handle;
+        uint32_t nb_hosts;
+        uint32_t extra_hosts;  // nb_hosts if the job still runs at the shadow time, 0 otherwise
+        double value;          // Node-seconds used before the shadow time
+    };
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double, std::milli>(lookahead_budget_ms);
+    uint32_t free_now = available_res.size();
+    double horizon = shadow_time - current_time;
+    bool use_horizon = horizon > 0 && horizon != std::numeric_limits<double>::infinity();
 
-    if (log_file.is_open()) {
+    std::vector<Candidate> candidates;
+    size_t scanned = 0;
+    uint32_t total_hosts = 0;
+    uint32_t total_extra_hosts = 0;
+    JobQueue::Handle head = jobs->top();
+    jobs->visit_in_order([&](JobQueue::Handle handle, SchedJob* job) {
+        if (handle == head) {
+            return true;
+        }
+        scanned++;
+        if (job->nb_hosts == 0 || job->nb_hosts > free_now) {
+            return true;
+        }
+        double predicted = planned_walltime(job);
+        bool ends_before_shadow = predicted > 0 && current_time + predicted <= shadow_time;
+        if (!ends_before_shadow && job->nb_hosts > extra_nodes) {
+            return true;
+        }
+        uint32_t extra_hosts = ends_before_shadow ? 0 : job->nb_hosts;
+        double value = job->nb_hosts * (use_horizon ? (ends_before_shadow ? predicted : horizon) : 1.0);
+        candidates.push_back(Candidate{handle, job->nb_hosts, extra_hosts, value});
+        total_hosts += job->nb_hosts;
+        total_extra_hosts += extra_hosts;
+        return candidates.size() < lookahead_depth;
+    });
+    if (candidates.empty()) {
+        return scanned;
+    }
 
-        log_file << buffer;
+    // best[hosts * width + extra]: most value with at most hosts free hosts and extra extra nodes.
+    size_t capacity = std::min(free_now, total_hosts);
+    size_t extra_capacity = std::min<size_t>({extra_nodes, capacity, total_extra_hosts});
+    size_t width = extra_capacity + 1;
+    size_t nb_cells = (capacity + 1) * width;
+    size_t max_candidates = LOOKAHEAD_MAX_CELLS / nb_cells;
+    if (max_candidates == 0) {
+        SCHED_DEBUG("Lookahead skipped: %zu hosts and %zu extra nodes\n", capacity, extra_capacity);
+        return scanned;
+    }
+    candidates.resize(std::min(candidates.size(), max_candidates));
+    // The tables only grow, and the row of a candidate is cleared when it is added, so that the
+    // time they take stays within the budget.
+    std::vector<double> &best = lookahead_best;
+    std::vector<uint8_t> &taken = lookahead_taken;
+    best.assign(nb_cells, 0.0);
+    if (taken.size() < candidates.size() * nb_cells) {
+        taken.resize(candidates.size() * nb_cells);
+    }
+    size_t nb_added = 0;
+    for (; nb_added < candidates.size(); ++nb_added) {
+        if (nb_added > 0 && std::chrono::steady_clock::now() > deadline) {
+            SCHED_DEBUG("Lookahead budget exceeded after %zu of %zu candidates\n", nb_added, candidates.size());
+            break;
+        }
+        const Candidate &candidate = candidates[nb_added];
+        uint8_t *candidate_taken = &taken[nb_added * nb_cells];
+        std::fill(candidate_taken, candidate_taken + nb_cells, 0);
+        for (size_t hosts = capacity; hosts >= candidate.nb_hosts && hosts != SIZE_MAX; --hosts) {
+            for (size_t extra = extra_capacity; extra >= candidate.extra_hosts && extra != SIZE_MAX; --extra) {
+                size_t cell = hosts * width + extra;
+                double with = best[cell - candidate.nb_hosts * width - candidate.extra_hosts] + candidate.value;
+                if (with > best[cell]) {
+                    best[cell] = with;
+                    candidate_taken[cell] = 1;
+                }
+            }
+        }
+    }
 
-        log_file.flush();  // Ensure it's written immediately
+    // Walk the choices back from the full capacities, then start the chosen jobs in queue order.
+    std::vector<bool> chosen(nb_added, false);
+    size_t cell = capacity * width + extra_capacity;
+    for (size_t i = nb_added; i-- > 0;) {
+        if (taken[i * nb_cells + cell]) {
+            chosen[i] = true;
+            cell -= candidates[i].nb_hosts * width + candidates[i].extra_hosts;
+        }
     }
+    for (size_t i = 0; i < nb_added; ++i) {
+        if (chosen[i]) {
+            extra_nodes -= candidates[i].extra_hosts;
+            start_backfilled_job(jobs->item(candidates[i].handle), current_time);
+            jobs->erase(candidates[i].handle);
+        }
+    }
+    return scanned;
 }
 
 // -------------------------
@@ -137,9 +374,12 @@ extern "C" uint8_t batsim_edc_take_decisions(
     uint8_t **decisions,
     uint32_t *decisions_size)
 {
-    (void) what_happened_size;
+    DecisionTimer timer;
     auto *parsed = deserialize_message(*mb, !format_binary, what_happened);
     mb->clear(parsed->now());
+    timer.end_phase(PHASE_DESERIALIZE);
+    
+    double current_time = parsed->now();
     
     auto nb_events = parsed->events()->size();
     for (unsigned int i = 0; i < nb_events; ++i) {
@@ -153,6 +393,7 @@ extern "C" uint8_t batsim_edc_take_decisions(
             case fb::Event_SimulationBeginsEvent: {
                 auto simu_begins = event->event_as_SimulationBeginsEvent();
                 platform_nb_hosts = simu_begins->computation_host_number();
+                online_metrics_simulation_begins(current_time, platform_nb_hosts);
                 
                 // Initialize available resources (hosts are numbered from 0 to platform_nb_hosts-1)
                 for (uint32_t i = 0; i < platform_nb_hosts; i++) {
@@ -165,26 +406,38 @@ extern "C" uint8_t batsim_edc_take_decisions(
                 auto job = new SchedJob();
                 job->job_id = parsed_job->job_id()->str();
                 job->nb_hosts = parsed_job->job()->resource_request();
+                job->walltime = parsed_job->job()->walltime();
+                job->profile_id = parsed_job->job()->profile_id()->str();
+                job->predicted_after = UINT64_MAX;  // Predicted when it is planned or started
+                job->submission_time = current_time;
+                job->submission_index = next_submission_index++;
+                online_metrics_job_submitted(job->job_id, current_time);
                 
                 // Reject jobs that request more hosts than available on the platform
                 if (job->nb_hosts > platform_nb_hosts) {
                     mb->add_reject_job(job->job_id);
+                    online_metrics_job_rejected(job->job_id, current_time);
                     delete job;
                 } else {
-                    jobs->push_back(job);
+                    // Scored at the same time as the jobs already waiting, so that the keys compare.
+                    jobs->push(job, priority_key(job, keys_time));
                 }
             } break;
             
             case fb::Event_JobCompletedEvent: {
                 auto parsed_job = event->event_as_JobCompletedEvent();
                 std::string completed_job_id = parsed_job->job_id()->str();
+                online_metrics_job_completed(completed_job_id, current_time);
                 
                 // If the job is still running, free its resources
                 if (running_jobs.count(completed_job_id)) {
                     SchedJob* completed_job = running_jobs[completed_job_id];
+                    walltime_predictor_observe(completed_job->job_id, completed_job->profile_id, completed_job->nb_hosts,
+                                               completed_job->walltime, current_time - completed_job->start_time);
                     for (uint32_t host : job_allocations[completed_job_id]) {
                         available_res.insert(host);
                     }
+                    running_ends.erase(completed_job->expected_end);
                     running_jobs.erase(completed_job_id);
                     job_allocations.erase(completed_job_id);
                     delete completed_job;
@@ -196,106 +449,101 @@ extern "C" uint8_t batsim_edc_take_decisions(
         }
     }
     
+    timer.end_phase(PHASE_EVENTS);
+    size_t queue_length = jobs->size();
+    size_t candidates_scanned = 0;
+
     // -------------------------
     // Scheduling loop with backfilling
-    // -------------------------    
-    while (!jobs->empty()) {
-        // Always try to schedule the job at the front of the queue first.
-        SchedJob* job = jobs->front();
-        
-        if (available_res.size() >= job->nb_hosts) {
-            // The front job fits: allocate the first nb_hosts resources available.
-            
-            std::set<uint32_t> job_resources;
-            auto it = available_res.begin();
-            for (uint8_t i = 0; i < job->nb_hosts; ++i, ++it) {
-                job_resources.insert(*it);
+    // -------------------------
+    // Scores that change with time are only recomputed when there are hosts to give, and at most
+    // every priority_refresh seconds: it sorts the whole queue again.
+    if (job_priority_depends_on_time(priority) && (keys_time < 0 || current_time - keys_time >= priority_refresh)
+        && keys_time != current_time && !jobs->empty() && !available_res.empty()) {
+        jobs->rekey([current_time](SchedJob* job) { return priority_key(job, current_time); });
+        keys_time = current_time;
+    }
+
+    if (walltime_predictor_enabled()) {
+        extend_overrun_predictions(current_time);
+    }
+
+    // First start the jobs at the front of the queue, in order, as long as they fit.
+    while (!jobs->empty() && available_res.size() >= jobs->item(jobs->top())->nb_hosts) {
+        SchedJob* job = jobs->item(jobs->top());
+        candidates_scanned++;
+        start_job(job, current_time);
+        jobs->pop();
+    }
+
+    if (!jobs->empty() && !available_res.empty()) {
+        // The front job does not fit: compute its shadow time and extra nodes by releasing
+        // the hosts of the running jobs in expected end order until it fits.
+        SchedJob* head_job = jobs->item(jobs->top());
+        candidates_scanned++;
+        double shadow_time = std::numeric_limits<double>::infinity();
+        uint32_t extra_nodes = 0;
+        uint32_t free_at_shadow = available_res.size();
+        for (auto &entry : running_ends) {
+            free_at_shadow += entry.second->nb_hosts;
+            if (free_at_shadow >= head_job->nb_hosts) {
+                shadow_time = std::max(entry.first, current_time);
+                extra_nodes = free_at_shadow - head_job->nb_hosts;
+                break;
             }
-            // Remove allocated resources from the available set.
-            for (uint32_t res : job_resources) {
-                available_res.erase(res);
+        }
+        SCHED_TRACE("Head job %s: shadow time %g, %u extra nodes\n",
+                    head_job->job_id.c_str(), shadow_time, extra_nodes);
+
+        if (lookahead_backfill) {
+            candidates_scanned += backfill_lookahead(current_time, shadow_time, extra_nodes);
+        }
+
+        // Then backfill the later jobs that fit now and do not delay the head job. They leave
+        // the queue once it has been walked.
+        JobQueue::Handle head = jobs->top();
+        std::vector<JobQueue::Handle> backfilled;
+        jobs->visit_in_order([&](JobQueue::Handle handle, SchedJob* backfill_job) {
+            if (handle == head) {
+                return true;
             }
-            running_jobs[job->job_id] = job;
-            job_allocations[job->job_id] = job_resources;
-            
-            // Build a comma-separated list of allocated resource IDs.
-            std::string resources_str;
-            for (auto it = job_resources.begin(); it != job_resources.end(); ++it) {
-                if (it != job_resources.begin())
-                    resources_str += ",";
-                resources_str += std::to_string(*it);
+            if (available_res.empty()) {
+                return false;
             }
-            mb->add_execute_job(job->job_id, resources_str);
-            jobs->pop_front();
-        } else {
-            // The front job does not fit: attempt to backfill one job from the rest of the queue.
-            bool backfilled = false;
-            // Start from the second job (if any).
-            for (auto job_it = std::next(jobs->begin()); job_it != jobs->end(); ++job_it) {
-                SchedJob* backfill_job = *job_it;
-                
-                if (available_res.size() >= backfill_job->nb_hosts) {
-                    std::set<uint32_t> job_resources;
-                    auto res_it = available_res.begin();
-                    for (uint8_t i = 0; i < backfill_job->nb_hosts; ++i, ++res_it) {
-                        job_resources.insert(*res_it);
-                    }
-                    for (uint32_t res : job_resources) {
-                        available_res.erase(res);
-                    }
-                    running_jobs[backfill_job->job_id] = backfill_job;
-                    job_allocations[backfill_job->job_id] = job_resources;
-                    
-                    std::string resources_str;
-                    for (auto res_iter = job_resources.begin(); res_iter != job_resources.end(); ++res_iter) {
-                        if (res_iter != job_resources.begin())
-                            resources_str += ",";
-                        resources_str += std::to_string(*res_iter);
-                    }
-                    mb->add_execute_job(backfill_job->job_id, resources_str);
-                    
-                    // Remove the backfilled job from the pending queue.
-                    jobs->erase(job_it);
-                    backfilled = true;
-                    backfill_success_count++;
-                    
-                    // Check if the allocated resources are contiguous
-                    bool is_contiguous = true;
-                    auto it_res = job_resources.begin();
-                    auto next = std::next(it_res);
-                    while (next != job_resources.end()) {
-                        if (*next - *it_res != 1) {
-                            is_contiguous = false;
-                            break;
-                        }
-                        ++it_res;
-                        ++next;
-                    }
-                    
-                    if (is_contiguous) {
-                        contiguous_backfill_count++;
-                    } else {
-                        non_contiguous_backfill_count++;
-                    }
-                    
-                    break; // Schedule at most one backfilled job in this decision cycle.
-                }
+            candidates_scanned++;
+
+            if (available_res.size() < backfill_job->nb_hosts) {
+                return true;
             }
-            // If no pending job (other than the front) can be scheduled, then break out.
-            if (!backfilled) {
-                break;
-            } else {
-                // (Optionally, you could continue the loop to check for more opportunities.)
-                break;
+            double predicted = planned_walltime(backfill_job);
+            bool ends_before_shadow = predicted > 0 && current_time + predicted <= shadow_time;
+            if (!ends_before_shadow) {
+                if (backfill_job->nb_hosts > extra_nodes) {
+                    return true;
+                }
+                // Still running at the shadow time: uses hosts the head job will not need.
+                extra_nodes -= backfill_job->nb_hosts;
             }
+
+            start_backfilled_job(backfill_job, current_time);
+            backfilled.push_back(handle);
+            return true;
+        });
+        for (JobQueue::Handle handle : backfilled) {
+            jobs->erase(handle);
         }
     }
-    
+
     log_message("%u %u %u\n",
            backfill_success_count, contiguous_backfill_count, non_contiguous_backfill_count);
     
+    timer.end_phase(PHASE_SCHEDULING);
+
     mb->finish_message(parsed->now());
     serialize_message(*mb, !format_binary, const_cast<const uint8_t **>(decisions), decisions_size);
+    timer.end_phase(PHASE_SERIALIZE);
+    timer.finish(queue_length, candidates_scanned);
+    msg_trace_record(what_happened, what_happened_size, *decisions, *decisions_size);
     return 0;
 }
 
@@ -0,0 +1,54 @@
+// edc_config.cpp
+//
+// Parsing of the batsim_edc_init() initialization data, see edc_config.hpp.
+
+#include "edc_config.hpp"
+
+#include <cctype>
+#include <cstdio>
+
+bool EdcConfig::has(const std::string &key) const {
+    return values.contains(key) && !values[key].is_null();
+}
+
+std::string EdcConfig::get_string(const std::string &key, const std::string &fallback) const {
+    if (!has(key) || !values[key].is_string()) {
+        return fallback;
+    }
+    return values[key].get<std::string>();
+}
+
+double EdcConfig::get_number(const std::string &key, double fallback) const {
+    if (!has(key) || !values[key].is_number()) {
+        return fallback;
+    }
+    return values[key].get<double>();
+}
+
+bool EdcConfig::get_bool(const std::string &key, bool fallback) const {
+    if (!has(key) || !values[key].is_boolean()) {
+        return fallback;
+    }
+    return values[key].get<bool>();
+}
+
+bool parse_edc_config(const uint8_t *data, uint32_t size, EdcConfig &config) {
+    config.values = nlohmann::json::object();
+
+    // Batsim may or may not count the terminating NUL, and '' on the command line means no data.
+    std::string text(reinterpret_cast<const char *>(data), data == nullptr ? 0 : size);
+    while (!text.empty() && (text.back() == '\0' || isspace(static_cast<unsigned char>(text.back())))) {
+        text.pop_back();
+    }
+    if (text.empty()) {
+        return true;
+    }
+
+    auto parsed = nlohmann::json::parse(text, nullptr, false);
+    if (parsed.is_discarded() || !parsed.is_object()) {
+        printf("Initialization data is not a JSON object: '%s'\n", text.c_str());
+        return false;
+    }
+    config.values = std::move(parsed);
+    return true;
+}
@@ -0,0 +1,26 @@
+// edc_config.hpp
+//
+// Access to the initialization data given to batsim_edc_init().
+// The data is an optional JSON object passed on Batsim's command line, for example:
+//   batsim -l ./build/libbasic.so 0 '{"log_file": "out/basic_log.txt"}' ...
+// An empty string keeps every scheduler on its defaults.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+struct EdcConfig {
+    nlohmann::json values = nlohmann::json::object();
+
+    bool has(const std::string &key) const;
+    std::string get_string(const std::string &key, const std::string &fallback) const;
+    double get_number(const std::string &key, double fallback) const;
+    bool get_bool(const std::string &key, bool fallback) const;
+};
+
+// Parses the initialization data into config.
+// Returns false (and prints why) if the data is neither empty nor a JSON object.
+bool parse_edc_config(const uint8_t *data, uint32_t size, EdcConfig &config);
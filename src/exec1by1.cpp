@@ -5,6 +5,11 @@
 #include <intervalset.hpp>
 
 #include "batsim_edc.h"
+#include "edc_config.hpp"
+#include "decision_stats.hpp"
+#include "log_level.hpp"
+#include "online_metrics.hpp"
+#include "msg_trace.hpp"
 
 using namespace batprotocol;
 
@@ -23,22 +28,33 @@ uint32_t platform_nb_hosts = 0;
 uint8_t batsim_edc_init(const uint8_t * data, uint32_t size, uint32_t flags) {
   format_binary = ((flags & BATSIM_EDC_FORMAT_BINARY) != 0);
   if ((flags & (BATSIM_EDC_FORMAT_BINARY | BATSIM_EDC_FORMAT_JSON)) != flags) {
-    printf("Unknown flags used, cannot initialize myself.\n");
+    SCHED_ERROR("Unknown flags used, cannot initialize myself.\n");
+    return 1;
+  }
+
+  EdcConfig config;
+  if (!parse_edc_config(data, size, config) || !log_level_init(config)) {
+    return 1;
+  }
+  if (!msg_trace_open(config, data, size, flags)) {
     return 1;
   }
 
   mb = new MessageBuilder(!format_binary);
   jobs = new std::list<SchedJob*>();
 
-  // ignore initialization data
-  (void) data;
-  (void) size;
+  decision_stats_init(config, "exec1by1");
+  online_metrics_init(config, "exec1by1");
 
   return 0;
 }
 
 // this function is called by batsim to deinitialize your decision code
 uint8_t batsim_edc_deinit() {
+  decision_stats_dump();
+  online_metrics_dump();
+  msg_trace_close();
+
   delete mb;
   mb = nullptr;
 
@@ -50,6 +66,9 @@ uint8_t batsim_edc_deinit() {
     jobs = nullptr;
   }
 
+  delete currently_running_job;
+  currently_running_job = nullptr;
+
   return 0;
 }
 
@@ -60,7 +79,7 @@ uint8_t batsim_edc_take_decisions(
   uint8_t ** decisions,
   uint32_t * decisions_size)
 {
-  (void) what_happened_size;
+  DecisionTimer timer;
 
   // deserialize the message received
   auto * parsed = deserialize_message(*mb, !format_binary, what_happened);
@@ -68,12 +87,13 @@ uint8_t batsim_edc_take_decisions(
   // clear data structures to take the next decisions.
   // decisions will now use the current time, as received from batsim
   mb->clear(parsed->now());
+  timer.end_phase(PHASE_DESERIALIZE);
 
   // traverse all events that have just been received
   auto nb_events = parsed->events()->size();
   for (unsigned int i = 0; i < nb_events; ++i) {
     auto event = (*parsed->events())[i];
-    printf("exec1by1 received event type='%s'\n", batprotocol::fb::EnumNamesEvent()[event->event_type()]);
+    SCHED_TRACE("exec1by1 received event type='%s'\n", batprotocol::fb::EnumNamesEvent()[event->event_type()]);
     switch (event->event_type()) {
       // protocol handshake
       case fb::Event_BatsimHelloEvent: {
@@ -83,6 +103,7 @@ uint8_t batsim_edc_take_decisions(
       case fb::Event_SimulationBeginsEvent: {
         auto simu_begins = event->event_as_SimulationBeginsEvent();
         platform_nb_hosts = simu_begins->computation_host_number();
+        online_metrics_simulation_begins(parsed->now(), platform_nb_hosts);
       } break;
       // a job has just been submitted
       case fb::Event_JobSubmittedEvent: {
@@ -91,8 +112,10 @@ uint8_t batsim_edc_take_decisions(
         job->job_id = parsed_job->job_id()->str();
 
         job->nb_hosts = parsed_job->job()->resource_request();
+        online_metrics_job_submitted(job->job_id, parsed->now());
         if (job->nb_hosts > platform_nb_hosts) {
           mb->add_reject_job(job->job_id);
+          online_metrics_job_rejected(job->job_id, parsed->now());
           delete job;
         }
         else {
@@ -101,6 +124,7 @@ uint8_t batsim_edc_take_decisions(
       } break;
       // a job has just completed
       case fb::Event_JobCompletedEvent: {
+        online_metrics_job_completed(event->event_as_JobCompletedEvent()->job_id()->str(), parsed->now());
         delete currently_running_job;
         currently_running_job = nullptr;
       } break;
@@ -108,16 +132,27 @@ uint8_t batsim_edc_take_decisions(
     }
   }
 
+  timer.end_phase(PHASE_EVENTS);
+  size_t queue_length = jobs->size();
+  size_t candidates_scanned = 0;
+
   // run one job if the platform is unused and if there is a job waiting
   if (currently_running_job == nullptr && !jobs->empty()) {
+    candidates_scanned++;
     currently_running_job = jobs->front();
     jobs->pop_front();
     auto hosts = IntervalSet(IntervalSet::ClosedInterval(0, currently_running_job->nb_hosts-1));
     mb->add_execute_job(currently_running_job->job_id, hosts.to_string_hyphen());
+    online_metrics_job_started(currently_running_job->job_id, parsed->now(), hosts);
   }
 
+  timer.end_phase(PHASE_SCHEDULING);
+
   // serialize decisions that have been taken into the output parameters of the function (decisions, decisions_size)
   mb->finish_message(parsed->now());
   serialize_message(*mb, !format_binary, const_cast<const uint8_t **>(decisions), decisions_size);
+  timer.end_phase(PHASE_SERIALIZE);
+  timer.finish(queue_length, candidates_scanned);
+  msg_trace_record(what_happened, what_happened_size, *decisions, *decisions_size);
   return 0;
 }
@@ -7,6 +7,11 @@
 #include <unordered_map>
 
 #include "batsim_edc.h"
+#include "edc_config.hpp"
+#include "decision_stats.hpp"
+#include "log_level.hpp"
+#include "online_metrics.hpp"
+#include "msg_trace.hpp"
 
 using namespace batprotocol;
 
@@ -32,7 +37,15 @@ std::list<SchedJob*> * running_jobs = nullptr;
 uint8_t batsim_edc_init(const uint8_t * data, uint32_t size, uint32_t flags) {
   format_binary = ((flags & BATSIM_EDC_FORMAT_BINARY) != 0);
   if ((flags & (BATSIM_EDC_FORMAT_BINARY | BATSIM_EDC_FORMAT_JSON)) != flags) {
-    printf("Unknown flags used, cannot initialize myself.\n");
+    SCHED_ERROR("Unknown flags used, cannot initialize myself.\n");
+    return 1;
+  }
+
+  EdcConfig config;
+  if (!parse_edc_config(data, size, config) || !log_level_init(config)) {
+    return 1;
+  }
+  if (!msg_trace_open(config, data, size, flags)) {
     return 1;
   }
 
@@ -40,15 +53,18 @@ uint8_t batsim_edc_init(const uint8_t * data, uint32_t size, uint32_t flags) {
   jobs = new std::list<SchedJob*>();
   running_jobs = new std::list<SchedJob*>();
 
-  // ignore initialization data
-  (void) data;
-  (void) size;
+  decision_stats_init(config, "fcfs");
+  online_metrics_init(config, "fcfs");
 
   return 0;
 }
 
 // this function is called by batsim to deinitialize your decision code
 uint8_t batsim_edc_deinit() {
+  decision_stats_dump();
+  online_metrics_dump();
+  msg_trace_close();
+
   delete mb;
   mb = nullptr;
 
@@ -78,7 +94,7 @@ uint8_t batsim_edc_take_decisions(
   uint8_t ** decisions,
   uint32_t * decisions_size)
 {
-  (void) what_happened_size;
+  DecisionTimer timer;
 
   // deserialize the message received
   auto * parsed = deserialize_message(*mb, !format_binary, what_happened);
@@ -86,12 +102,13 @@ uint8_t batsim_edc_take_decisions(
   // clear data structures to take the next decisions.
   // decisions will now use the current time, as received from batsim
   mb->clear(parsed->now());
+  timer.end_phase(PHASE_DESERIALIZE);
 
   // traverse all events that have just been received
   auto nb_events = parsed->events()->size();
   for (unsigned int i = 0; i < nb_events; ++i) {
     auto event = (*parsed->events())[i];
-    printf("fcfs received event type='%s'\n", batprotocol::fb::EnumNamesEvent()[event->event_type()]);
+    SCHED_TRACE("fcfs received event type='%s'\n", batprotocol::fb::EnumNamesEvent()[event->event_type()]);
     switch (event->event_type()) {
       // protocol handshake
       case fb::Event_BatsimHelloEvent: {
@@ -102,6 +119,7 @@ uint8_t batsim_edc_take_decisions(
 
         auto simu_begins = event->event_as_SimulationBeginsEvent();
         platform_nb_hosts = simu_begins->computation_host_number();
+        online_metrics_simulation_begins(parsed->now(), platform_nb_hosts);
         // Init available resources
         available_resources = IntervalSet(IntervalSet::ClosedInterval(0, platform_nb_hosts-1));
       } break;
@@ -114,9 +132,11 @@ uint8_t batsim_edc_take_decisions(
         job->job_id = parsed_job->job_id()->str();
 
         job->nb_hosts = parsed_job->job()->resource_request();
+        online_metrics_job_submitted(job->job_id, parsed->now());
         // if you want to initialize the IntervalSet, do it here
         if (job->nb_hosts > platform_nb_hosts) {
           mb->add_reject_job(job->job_id);
+          online_metrics_job_rejected(job->job_id, parsed->now());
           delete job;
         }
         else {
@@ -126,6 +146,7 @@ uint8_t batsim_edc_take_decisions(
       // a job has just completed
       case fb::Event_JobCompletedEvent: {
         auto parsed_event = event->event_as_JobCompletedEvent();  
+        online_metrics_job_completed(parsed_event->job_id()->str(), parsed->now());
         
         //retrieves info about job
         auto job_it = running_jobs->begin();
@@ -146,9 +167,14 @@ uint8_t batsim_edc_take_decisions(
     }
   }
 
+  timer.end_phase(PHASE_EVENTS);
+  size_t queue_length = jobs->size();
+  size_t candidates_scanned = 0;
+
   // First Come First Served will run jobs in queue order if the host is ready and the queue is not empty
   while (!jobs->empty()) {
     SchedJob* new_job = jobs->front();
+    candidates_scanned++;
     //  THIS SHOULD NOT BE EXECUTED SINCE WE DON'T WANT TO REMOVE THE JOB IF WE ARE NOT SURE
   
     if((new_job->nb_hosts) <= available_resources.size()){
@@ -160,6 +186,7 @@ uint8_t batsim_edc_take_decisions(
       new_job->assigned_resources = assigned_hosts;
       //  EXECUTE JOBS
       mb->add_execute_job(new_job->job_id, assigned_hosts.to_string_hyphen());
+      online_metrics_job_started(new_job->job_id, parsed->now(), assigned_hosts);
       //  update running jobs map
       //  running_jobs[new_job->job_id] = assigned_hosts.to_string_hyphen();
       running_jobs->push_back(new_job);
@@ -171,8 +198,13 @@ uint8_t batsim_edc_take_decisions(
     }
   }
 
+  timer.end_phase(PHASE_SCHEDULING);
+
   // serialize decisions that have been taken into the output parameters of the function (decisions, decisions_size)
   mb->finish_message(parsed->now());
   serialize_message(*mb, !format_binary, const_cast<const uint8_t **>(decisions), decisions_size);
+  timer.end_phase(PHASE_SERIALIZE);
+  timer.finish(queue_length, candidates_scanned);
+  msg_trace_record(what_happened, what_happened_size, *decisions, *decisions_size);
   return 0;
 }
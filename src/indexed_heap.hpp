@@ -0,0 +1,217 @@
+// indexed_heap.hpp
+//
+// Binary min-heap that knows where each of its items is, so that any item can be removed in
+// O(log n), without searching for it. push() returns a handle that stays valid until the item is popped or erased; handles of
+// removed items are reused.
+// Keys are compared with Compare (std::less by default): the top is the smallest key. Give keys
+// a unique tie-breaker (e.g. a submission index) when the order of equal keys matters.
+// Walking all the items in key order (visit_in_order(), e.g. a backfilling pass over the whole
+// queue) would cost O(n log n) on the heap alone, so the heap also keeps a sorted copy of its
+// items, brought up to date at the next walk: erased items are dropped and pushed items merged in
+// (O(n + p log p) for p pushes), and only rekey() makes it sort everything again.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+template <typename Item, typename Key, typename Compare = std::less<Key>>
+class IndexedHeap {
+public:
+    typedef uint32_t Handle;
+
+    bool empty() const { return heap_.empty(); }
+    size_t size() const { return heap_.size(); }
+
+    Handle push(const Item &item, const Key &key) {
+        Handle handle;
+        if (!free_handles_.empty()) {
+            handle = free_handles_.back();
+            free_handles_.pop_back();
+            slots_[handle] = Slot{item, heap_.size()};
+        } else {
+            handle = static_cast<Handle>(slots_.size());
+            slots_.push_back(Slot{item, heap_.size()});
+            generations_.push_back(0);
+        }
+        heap_.push_back(Entry{key, handle});
+        sift_up(heap_.size() - 1);
+        if (order_valid_) {
+            pushed_.push_back(OrderEntry{key, item, handle, generations_[handle]});
+        }
+        return handle;
+    }
+
+    Handle top() const { return heap_.front().handle; }
+    const Item &item(Handle handle) const { return slots_[handle].item; }
+    const Key &key(Handle handle) const { return heap_[slots_[handle].position].key; }
+
+    void pop() { erase(heap_.front().handle); }
+
+    void erase(Handle handle) {
+        size_t position = slots_[handle].position;
+        move(heap_.back(), position);
+        heap_.pop_back();
+        free_handles_.push_back(handle);
+        generations_[handle]++;
+        nb_erased_++;
+        if (position < heap_.size()) {
+            restore(position);
+        }
+    }
+
+    // Recomputes every key with key_of(item) and rebuilds the heap in O(n), for keys that all
+    // change at once (e.g. scores that depend on the current time).
+    template <typename KeyOf>
+    void rekey(KeyOf key_of) {
+        for (Entry &entry : heap_) {
+            entry.key = key_of(slots_[entry.handle].item);
+        }
+        for (size_t position = heap_.size() / 2; position-- > 0;) {
+            sift_down(position);
+        }
+        order_valid_ = false;
+    }
+
+    // Calls visit(handle, item) on the items in key order until it returns false. visit must not
+    // modify the heap.
+    template <typename Visit>
+    void visit_in_order(Visit visit) {
+        update_order();
+        for (const OrderEntry &entry : order_) {
+            if (!visit(entry.handle, entry.item)) {
+                return;
+            }
+        }
+    }
+
+    void clear() {
+        slots_.clear();
+        generations_.clear();
+        free_handles_.clear();
+        heap_.clear();
+        order_.clear();
+        pushed_.clear();
+        nb_erased_ = 0;
+        order_valid_ = false;
+    }
+
+private:
+    struct Slot {
+        Item item;
+        size_t position;  // Index in heap_
+    };
+    // The keys are stored in the heap itself, so that sifting does not follow the handles.
+    struct Entry {
+        Key key;
+        Handle handle;
+    };
+
+    // Copies of the key and the item, so that walking the order does not touch the slots.
+    struct OrderEntry {
+        Key key;
+        Item item;
+        Handle handle;
+        uint32_t generation;
+    };
+
+    bool less(const Entry &a, const Entry &b) const { return compare_(a.key, b.key); }
+
+    // Brings order_ up to date with the heap.
+    void update_order() {
+        auto order_less = [this](const OrderEntry &a, const OrderEntry &b) { return compare_(a.key, b.key); };
+        if (!order_valid_) {
+            order_.clear();
+            for (const Entry &entry : heap_) {
+                order_.push_back(OrderEntry{entry.key, slots_[entry.handle].item, entry.handle, generations_[entry.handle]});
+            }
+            std::sort(order_.begin(), order_.end(), order_less);
+            pushed_.clear();
+            nb_erased_ = 0;
+            order_valid_ = true;
+            return;
+        }
+        if (nb_erased_ == 0 && pushed_.empty()) {
+            return;
+        }
+        // One pass merges the pushed items in and drops the erased ones.
+        auto erased = [this](const OrderEntry &entry) { return generations_[entry.handle] != entry.generation; };
+        pushed_.erase(std::remove_if(pushed_.begin(), pushed_.end(), erased), pushed_.end());
+        std::sort(pushed_.begin(), pushed_.end(), order_less);
+        merged_.clear();
+        auto next_pushed = pushed_.begin();
+        for (const OrderEntry &entry : order_) {
+            if (nb_erased_ > 0 && erased(entry)) {
+                continue;
+            }
+            while (next_pushed != pushed_.end() && order_less(*next_pushed, entry)) {
+                merged_.push_back(*next_pushed++);
+            }
+            merged_.push_back(entry);
+        }
+        merged_.insert(merged_.end(), next_pushed, pushed_.end());
+        order_.swap(merged_);
+        pushed_.clear();
+        nb_erased_ = 0;
+    }
+
+    void move(const Entry &entry, size_t position) {
+        heap_[position] = entry;
+        slots_[entry.handle].position = position;
+    }
+
+    void restore(size_t position) {
+        if (position > 0 && less(heap_[position], heap_[(position - 1) / 2])) {
+            sift_up(position);
+        } else {
+            sift_down(position);
+        }
+    }
+
+    void sift_up(size_t position) {
+        Entry entry = heap_[position];
+        while (position > 0) {
+            size_t parent = (position - 1) / 2;
+            if (!less(entry, heap_[parent])) {
+                break;
+            }
+            move(heap_[parent], position);
+            position = parent;
+        }
+        move(entry, position);
+    }
+
+    void sift_down(size_t position) {
+        Entry entry = heap_[position];
+        while (true) {
+            size_t child = 2 * position + 1;
+            if (child >= heap_.size()) {
+                break;
+            }
+            if (child + 1 < heap_.size() && less(heap_[child + 1], heap_[child])) {
+                child++;
+            }
+            if (!less(heap_[child], entry)) {
+                break;
+            }
+            move(heap_[child], position);
+            position = child;
+        }
+        move(entry, position);
+    }
+
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> generations_;  // Per handle, incremented when its item is erased
+    std::vector<Handle> free_handles_;
+    std::vector<Entry> heap_;
+    std::vector<OrderEntry> order_;   // Items in key order, valid if order_valid_, see update_order()
+    std::vector<OrderEntry> pushed_;  // Items pushed since, not in order_ yet
+    std::vector<OrderEntry> merged_;  // Buffer of update_order()
+    size_t nb_erased_ = 0;            // Items erased since, still in order_
+    bool order_valid_ = false;
+    Compare compare_;
+};
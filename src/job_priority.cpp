@@ -0,0 +1,56 @@
+// job_priority.cpp
+//
+// Scores of the job orderings, see job_priority.hpp.
+
+#include "job_priority.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+const char *priority_names[] = {"fcfs", "sjf", "largest", "wfp", "f1"};
+
+} // namespace
+
+bool job_priority_init(const EdcConfig &config, JobPriority &priority) {
+    std::string name = config.get_string("priority", "fcfs");
+    for (int candidate = PRIORITY_FCFS; candidate <= PRIORITY_F1; ++candidate) {
+        if (name == priority_names[candidate]) {
+            priority = static_cast<JobPriority>(candidate);
+            return true;
+        }
+    }
+    printf("Unknown priority '%s' (expected fcfs, sjf, largest, wfp or f1)\n", name.c_str());
+    return false;
+}
+
+const char *job_priority_name(JobPriority priority) {
+    return priority_names[priority];
+}
+
+bool job_priority_depends_on_time(JobPriority priority) {
+    return priority == PRIORITY_WFP;
+}
+
+double job_priority_score(JobPriority priority, double submission_time, double walltime, uint32_t nb_hosts, double now) {
+    double requested = (walltime > 0) ? walltime : UNKNOWN_WALLTIME;
+    switch (priority) {
+        case PRIORITY_FCFS:
+            return 0;  // Submission index only
+        case PRIORITY_SJF:
+            return requested;
+        case PRIORITY_LARGEST:
+            return -static_cast<double>(nb_hosts);
+        case PRIORITY_WFP: {
+            double ratio = std::max(now - submission_time, 0.0) / requested;
+            return -ratio * ratio * ratio * nb_hosts;
+        }
+        case PRIORITY_F1:
+            // Both logarithms are taken of at least one second.
+            return std::log10(std::max(requested, 1.0)) * nb_hosts + 870 * std::log10(std::max(submission_time, 1.0));
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+// job_priority.hpp
+//
+// Orderings of the waiting jobs, for the schedulers that keep their queue in an IndexedHeap
+// (indexed_heap.hpp) instead of submission order. Every ordering gives each job a score, lowest
+// first; equal scores keep submission order.
+//   fcfs      submission order
+//   sjf       shortest requested walltime first
+//   largest   most requested hosts first
+//   wfp       WFP3 (Tang et al.): highest (waiting time / walltime)^3 * hosts first, so that waiting
+//             jobs, and large ones first, catch up with the short ones
+//   f1        F1 (Carastan-Santos & de Camargo, learned from simulations):
+//             lowest log10(walltime) * hosts + 870 * log10(submission time) first
+// Jobs without walltime are scored as if they requested UNKNOWN_WALLTIME.
+// Init data key:
+//   "priority": "fcfs" | "sjf" | "largest" | "wfp" | "f1"   ("fcfs" by default)
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+#include "edc_config.hpp"
+
+enum JobPriority {
+    PRIORITY_FCFS = 0,
+    PRIORITY_SJF,
+    PRIORITY_LARGEST,
+    PRIORITY_WFP,
+    PRIORITY_F1
+};
+
+// Walltime used to score the jobs that give none (a week).
+const double UNKNOWN_WALLTIME = 7 * 86400;
+
+// Heap key of a waiting job: its score, then its submission index.
+typedef std::pair<double, uint64_t> PriorityKey;
+
+// Reads the ordering from the init data. Call from batsim_edc_init(), after parse_edc_config().
+// Returns false (and prints why) if "priority" is not a known ordering.
+bool job_priority_init(const EdcConfig &config, JobPriority &priority);
+
+const char *job_priority_name(JobPriority priority);
+
+// Whether the scores change as time passes, in which case the schedulers recompute them before
+// reading the order, at most once per decision call.
+bool job_priority_depends_on_time(JobPriority priority);
+
+// Score of a job at time now, lowest first. walltime <= 0 if the job gives none.
+double job_priority_score(JobPriority priority, double submission_time, double walltime, uint32_t nb_hosts, double now);
+
+inline PriorityKey job_priority_key(JobPriority priority, double submission_time, double walltime,
+                                    uint32_t nb_hosts, uint64_t submission_index, double now) {
+    return PriorityKey(job_priority_score(priority, submission_time, walltime, nb_hosts, now), submission_index);
+}
@@ -0,0 +1,98 @@
+// log_histogram.hpp
+//
+// A high-dynamic-range histogram of unsigned 64-bit values (HdrHistogram-like).
+// Values below 64 are counted exactly; above that, every power of two is split into
+// 32 linear sub-buckets, so any recorded value is known within ~3% over the whole
+// 0..2^64 range with a fixed 1920-bucket array. Recording is a couple of shifts and an
+// increment, which keeps it cheap enough for per-decision instrumentation.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+class LogHistogram {
+public:
+    static const unsigned SUB_BUCKET_BITS = 5;
+    static const unsigned SUB_BUCKETS = 1u << SUB_BUCKET_BITS;           // 32
+    static const unsigned NB_BUCKETS = 2 * SUB_BUCKETS + (63 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    void record(uint64_t value) {
+        buckets_[bucket_index(value)]++;
+        count_++;
+        sum_ += static_cast<double>(value);
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    void merge(const LogHistogram &other) {
+        for (unsigned i = 0; i < NB_BUCKETS; ++i) {
+            buckets_[i] += other.buckets_[i];
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t min() const { return count_ == 0 ? 0 : min_; }
+    uint64_t max() const { return max_; }
+    double sum() const { return sum_; }
+    double mean() const { return count_ == 0 ? 0 : sum_ / static_cast<double>(count_); }
+
+    // Value at quantile q in [0, 1], reported as the middle of its bucket (clamped to [min, max]).
+    uint64_t quantile(double q) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count_ - 1)) + 1;
+        uint64_t seen = 0;
+        for (unsigned i = 0; i < NB_BUCKETS; ++i) {
+            seen += buckets_[i];
+            if (seen >= rank) {
+                uint64_t low = bucket_lower_bound(i);
+                uint64_t middle = low + (bucket_width(i) - 1) / 2;
+                return std::max(min_, std::min(max_, middle));
+            }
+        }
+        return max_;
+    }
+
+    unsigned nb_buckets() const { return NB_BUCKETS; }
+    uint64_t bucket_count(unsigned index) const { return buckets_[index]; }
+
+    static unsigned bucket_index(uint64_t value) {
+        if (value < 2 * SUB_BUCKETS) {
+            return static_cast<unsigned>(value);
+        }
+        unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+        unsigned shift = msb - SUB_BUCKET_BITS;
+        return 2 * SUB_BUCKETS + (shift - 1) * SUB_BUCKETS + static_cast<unsigned>((value >> shift) - SUB_BUCKETS);
+    }
+
+    static uint64_t bucket_lower_bound(unsigned index) {
+        if (index < 2 * SUB_BUCKETS) {
+            return index;
+        }
+        unsigned shift = (index - 2 * SUB_BUCKETS) / SUB_BUCKETS + 1;
+        uint64_t sub = (index - 2 * SUB_BUCKETS) % SUB_BUCKETS + SUB_BUCKETS;
+        return sub << shift;
+    }
+
+    static uint64_t bucket_width(unsigned index) {
+        if (index < 2 * SUB_BUCKETS) {
+            return 1;
+        }
+        return uint64_t(1) << ((index - 2 * SUB_BUCKETS) / SUB_BUCKETS + 1);
+    }
+
+private:
+    std::array<uint64_t, NB_BUCKETS> buckets_{};
+    uint64_t count_ = 0;
+    double sum_ = 0;
+    uint64_t min_ = std::numeric_limits<uint64_t>::max();
+    uint64_t max_ = 0;
+};
@@ -0,0 +1,44 @@
+// log_level.cpp
+//
+// Runtime level and output of the scheduler console logging, see log_level.hpp.
+
+#include "log_level.hpp"
+
+#include <cstdarg>
+#include <cstdio>
+
+namespace {
+
+LogLevel runtime_level = LOG_LEVEL_INFO;
+
+const char *level_names[] = {"trace", "debug", "info", "warning", "error", "off"};
+
+} // namespace
+
+bool log_level_init(const EdcConfig &config) {
+    runtime_level = LOG_LEVEL_INFO;
+    std::string name = config.get_string("log_level", "info");
+    for (int level = LOG_LEVEL_TRACE; level <= LOG_LEVEL_OFF; ++level) {
+        if (name == level_names[level]) {
+            runtime_level = static_cast<LogLevel>(level);
+            if (runtime_level < SCHED_MIN_LOG_LEVEL) {
+                printf("Warning: log level '%s' is not compiled in, messages below '%s' are not available\n",
+                       name.c_str(), level_names[SCHED_MIN_LOG_LEVEL]);
+            }
+            return true;
+        }
+    }
+    printf("Unknown log level '%s' (expected trace, debug, info, warning, error or off)\n", name.c_str());
+    return false;
+}
+
+LogLevel log_runtime_level() {
+    return runtime_level;
+}
+
+void log_printf(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
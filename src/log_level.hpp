@@ -0,0 +1,61 @@
+// log_level.hpp
+//
+// Leveled console logging shared by the schedulers.
+// Messages below SCHED_MIN_LOG_LEVEL are removed at compile time: the SCHED_TRACE()/SCHED_DEBUG()
+// calls of the decision path compile to nothing (their arguments are not even evaluated), so release
+// builds pay nothing for them. SCHED_MIN_LOG_LEVEL defaults to LOG_LEVEL_INFO when NDEBUG is defined
+// (meson release builds, see b_ndebug in meson.build) and to LOG_LEVEL_TRACE otherwise; it can be
+// forced with e.g. -DSCHED_MIN_LOG_LEVEL=LOG_LEVEL_DEBUG.
+// The messages that are compiled in are then filtered by the runtime level.
+// Init data key:
+//   "log_level": "trace" | "debug" | "info" | "warning" | "error" | "off"   ("info" by default)
+
+#pragma once
+
+#include "edc_config.hpp"
+
+enum LogLevel {
+    LOG_LEVEL_TRACE = 0,
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARNING,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_OFF
+};
+
+#ifndef SCHED_MIN_LOG_LEVEL
+#ifdef NDEBUG
+#define SCHED_MIN_LOG_LEVEL LOG_LEVEL_INFO
+#else
+#define SCHED_MIN_LOG_LEVEL LOG_LEVEL_TRACE
+#endif
+#endif
+
+// Reads the runtime level from the init data. Call once from batsim_edc_init(), after parse_edc_config().
+// Returns false (and prints why) if "log_level" is not a known level.
+bool log_level_init(const EdcConfig &config);
+
+LogLevel log_runtime_level();
+
+// Whether messages of this level are compiled in and enabled at runtime.
+inline bool log_level_enabled(LogLevel level) {
+    return level >= SCHED_MIN_LOG_LEVEL && level >= log_runtime_level();
+}
+
+// Writes a printf-formatted message to stdout. Use the macros below rather than calling it directly.
+void log_printf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+#define SCHED_LOG(level, ...)                                   \
+    do {                                                        \
+        if constexpr ((level) >= SCHED_MIN_LOG_LEVEL) {         \
+            if ((level) >= log_runtime_level()) {               \
+                log_printf(__VA_ARGS__);                        \
+            }                                                   \
+        }                                                       \
+    } while (0)
+
+#define SCHED_TRACE(...) SCHED_LOG(LOG_LEVEL_TRACE, __VA_ARGS__)
+#define SCHED_DEBUG(...) SCHED_LOG(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define SCHED_INFO(...) SCHED_LOG(LOG_LEVEL_INFO, __VA_ARGS__)
+#define SCHED_WARNING(...) SCHED_LOG(LOG_LEVEL_WARNING, __VA_ARGS__)
+#define SCHED_ERROR(...) SCHED_LOG(LOG_LEVEL_ERROR, __VA_ARGS__)
@@ -0,0 +1,119 @@
+// msg_trace.cpp
+//
+// Writing and reading of Batsim message traces, see msg_trace.hpp.
+
+#include "msg_trace.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const char trace_magic[8] = {'R', 'M', 'S', 'E', 'T', 'R', 'C', '1'};
+
+FILE *trace_file = nullptr;
+
+void write_u32(FILE *file, uint32_t value) {
+    uint8_t bytes[4] = {
+        static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8),
+        static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24)};
+    fwrite(bytes, 1, sizeof(bytes), file);
+}
+
+void write_block(FILE *file, const uint8_t *data, uint32_t size) {
+    write_u32(file, size);
+    if (size > 0) {
+        fwrite(data, 1, size, file);
+    }
+}
+
+bool read_u32(FILE *file, uint32_t &value) {
+    uint8_t bytes[4];
+    if (fread(bytes, 1, sizeof(bytes), file) != sizeof(bytes)) {
+        return false;
+    }
+    value = uint32_t(bytes[0]) | (uint32_t(bytes[1]) << 8) | (uint32_t(bytes[2]) << 16) | (uint32_t(bytes[3]) << 24);
+    return true;
+}
+
+bool read_block(FILE *file, std::vector<uint8_t> &block) {
+    uint32_t size = 0;
+    if (!read_u32(file, size)) {
+        return false;
+    }
+    block.resize(size);
+    return size == 0 || fread(block.data(), 1, size, file) == size;
+}
+
+} // namespace
+
+bool msg_trace_open(const EdcConfig &config, const uint8_t *data, uint32_t size, uint32_t flags) {
+    msg_trace_close();
+    std::string path = config.get_string("trace_file", "");
+    if (path.empty()) {
+        return true;
+    }
+
+    trace_file = fopen(path.c_str(), "wb");
+    if (trace_file == nullptr) {
+        printf("Could not open trace file '%s' for writing\n", path.c_str());
+        return false;
+    }
+    // Records are small and numerous, let stdio batch them.
+    setvbuf(trace_file, nullptr, _IOFBF, 1 << 20);
+
+    fwrite(trace_magic, 1, sizeof(trace_magic), trace_file);
+    write_u32(trace_file, flags);
+    write_block(trace_file, data, data == nullptr ? 0 : size);
+    return true;
+}
+
+void msg_trace_record(const uint8_t *what_happened, uint32_t what_happened_size,
+                      const uint8_t *decisions, uint32_t decisions_size) {
+    if (trace_file == nullptr) {
+        return;
+    }
+    write_block(trace_file, what_happened, what_happened_size);
+    write_block(trace_file, decisions, decisions_size);
+}
+
+void msg_trace_close() {
+    if (trace_file != nullptr) {
+        fclose(trace_file);
+        trace_file = nullptr;
+    }
+}
+
+bool load_message_trace(const std::string &path, MessageTrace &trace, std::string &error) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        error = "cannot open trace file '" + path + "'";
+        return false;
+    }
+
+    trace = MessageTrace();
+    char magic[sizeof(trace_magic)];
+    std::vector<uint8_t> init_data;
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, trace_magic, sizeof(magic)) != 0
+        || !read_u32(file, trace.flags) || !read_block(file, init_data)) {
+        fclose(file);
+        error = "'" + path + "' is not a message trace";
+        return false;
+    }
+    trace.init_data.assign(init_data.begin(), init_data.end());
+
+    while (true) {
+        MessageTrace::Call call;
+        if (!read_block(file, call.what_happened)) {
+            break; // end of the trace
+        }
+        if (!read_block(file, call.decisions)) {
+            fclose(file);
+            error = "'" + path + "' is truncated after " + std::to_string(trace.calls.size()) + " calls";
+            return false;
+        }
+        trace.calls.push_back(std::move(call));
+    }
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,40 @@
+// msg_trace.hpp
+//
+// Recording of the exact message stream exchanged with Batsim, so that a decision call can be
+// reproduced (and benchmarked) without rerunning the simulation. See src/tools/replay.cpp.
+//
+// Recording is enabled by the "trace_file" key of the init data. The file layout is, with all
+// integers little-endian:
+//   "RMSETRC1"                         magic (8 bytes)
+//   u32 flags                          flags given to batsim_edc_init()
+//   u32 size, data[size]               init data given to batsim_edc_init()
+//   then one record per batsim_edc_take_decisions() call:
+//   u32 size, what_happened[size]
+//   u32 size, decisions[size]
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "edc_config.hpp"
+
+// Starts recording if the init data asks for it. Returns false if the trace file cannot be created.
+bool msg_trace_open(const EdcConfig &config, const uint8_t *data, uint32_t size, uint32_t flags);
+void msg_trace_record(const uint8_t *what_happened, uint32_t what_happened_size,
+                      const uint8_t *decisions, uint32_t decisions_size);
+void msg_trace_close();
+
+struct MessageTrace {
+    uint32_t flags = 0;
+    std::string init_data;
+    struct Call {
+        std::vector<uint8_t> what_happened;
+        std::vector<uint8_t> decisions;
+    };
+    std::vector<Call> calls;
+};
+
+// Loads a whole trace written by msg_trace_record().
+bool load_message_trace(const std::string &path, MessageTrace &trace, std::string &error);
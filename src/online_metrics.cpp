@@ -0,0 +1,228 @@
+// online_metrics.cpp
+//
+// Accumulators and JSON summary of the online job metrics, see online_metrics.hpp.
+
+#include "online_metrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <unordered_map>
+
+#include <nlohmann/json.hpp>
+
+#include "log_histogram.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+// Durations and ratios are sketched in thousandths, which keeps sub-second waiting times apart.
+const double SKETCH_SCALE = 1000.0;
+
+struct TrackedJob {
+    double submission_time = 0;
+    double starting_time = -1; // < 0 while the job waits
+    uint32_t nb_hosts = 0;
+};
+
+struct Sketch {
+    LogHistogram histogram;
+    double sum = 0;
+
+    void record(double value) {
+        value = std::max(value, 0.0);
+        histogram.record(static_cast<uint64_t>(std::llround(value * SKETCH_SCALE)));
+        sum += value;
+    }
+
+    json to_json() const {
+        uint64_t count = histogram.count();
+        return json{
+            {"count", count},
+            {"mean", count == 0 ? 0.0 : sum / static_cast<double>(count)},
+            {"p50", static_cast<double>(histogram.quantile(0.5)) / SKETCH_SCALE},
+            {"p90", static_cast<double>(histogram.quantile(0.9)) / SKETCH_SCALE},
+            {"p99", static_cast<double>(histogram.quantile(0.99)) / SKETCH_SCALE},
+            {"max", static_cast<double>(histogram.max()) / SKETCH_SCALE}};
+    }
+};
+
+struct OnlineMetrics {
+    std::string scheduler;
+    std::string output_path;
+    double bounded_slowdown_threshold = 10;
+    uint32_t nb_hosts = 0;
+
+    std::unordered_map<std::string, TrackedJob> jobs; // submitted, not completed nor rejected yet
+    uint64_t nb_submitted = 0;
+    uint64_t nb_rejected = 0;
+    uint64_t nb_started = 0;
+    uint64_t nb_completed = 0;
+    uint64_t nb_contiguous = 0;
+    uint64_t nb_non_contiguous = 0;
+
+    // Piecewise-constant state, integrated over simulated time by advance().
+    double last_time = 0;
+    uint64_t busy_hosts = 0;
+    uint64_t waiting_jobs = 0;
+    uint64_t max_waiting_jobs = 0;
+    double busy_host_seconds = 0;
+    double queue_job_seconds = 0;
+    double last_completion = 0;
+
+    Sketch waiting_time;
+    Sketch turnaround_time;
+    Sketch bounded_slowdown;
+};
+
+bool enabled = false;
+std::unique_ptr<OnlineMetrics> metrics;
+
+void advance(double now) {
+    if (now > metrics->last_time) {
+        double elapsed = now - metrics->last_time;
+        metrics->busy_host_seconds += static_cast<double>(metrics->busy_hosts) * elapsed;
+        metrics->queue_job_seconds += static_cast<double>(metrics->waiting_jobs) * elapsed;
+        metrics->last_time = now;
+    }
+}
+
+} // namespace
+
+void online_metrics_init(const EdcConfig &config, const char *scheduler_name) {
+    enabled = config.get_bool("online_metrics", true);
+    metrics.reset();
+    if (!enabled) {
+        return;
+    }
+    metrics = std::make_unique<OnlineMetrics>();
+    metrics->scheduler = scheduler_name;
+    metrics->output_path = config.get_string("online_metrics_file", std::string(scheduler_name) + "_online_metrics.json");
+    metrics->bounded_slowdown_threshold = config.get_number("bounded_slowdown_threshold", 10);
+}
+
+void online_metrics_simulation_begins(double now, uint32_t nb_hosts) {
+    if (!enabled) {
+        return;
+    }
+    metrics->nb_hosts = nb_hosts;
+    metrics->last_time = now;
+}
+
+void online_metrics_job_submitted(const std::string &job_id, double now) {
+    if (!enabled) {
+        return;
+    }
+    advance(now);
+    TrackedJob &job = metrics->jobs[job_id];
+    job.submission_time = now;
+    metrics->nb_submitted++;
+    metrics->waiting_jobs++;
+    metrics->max_waiting_jobs = std::max(metrics->max_waiting_jobs, metrics->waiting_jobs);
+}
+
+void online_metrics_job_rejected(const std::string &job_id, double now) {
+    if (!enabled) {
+        return;
+    }
+    advance(now);
+    auto it = metrics->jobs.find(job_id);
+    if (it == metrics->jobs.end() || it->second.starting_time >= 0) {
+        return;
+    }
+    metrics->jobs.erase(it);
+    metrics->nb_rejected++;
+    metrics->waiting_jobs--;
+}
+
+void online_metrics_job_started(const std::string &job_id, double now, uint32_t nb_hosts, bool contiguous) {
+    if (!enabled) {
+        return;
+    }
+    advance(now);
+    auto it = metrics->jobs.find(job_id);
+    if (it == metrics->jobs.end() || it->second.starting_time >= 0) {
+        return;
+    }
+    it->second.starting_time = now;
+    it->second.nb_hosts = nb_hosts;
+    metrics->nb_started++;
+    metrics->waiting_jobs--;
+    metrics->busy_hosts += nb_hosts;
+    if (contiguous) {
+        metrics->nb_contiguous++;
+    } else {
+        metrics->nb_non_contiguous++;
+    }
+    metrics->waiting_time.record(now - it->second.submission_time);
+}
+
+void online_metrics_job_completed(const std::string &job_id, double now) {
+    if (!enabled) {
+        return;
+    }
+    advance(now);
+    auto it = metrics->jobs.find(job_id);
+    if (it == metrics->jobs.end() || it->second.starting_time < 0) {
+        return;
+    }
+    const TrackedJob &job = it->second;
+    double waiting = job.starting_time - job.submission_time;
+    double runtime = now - job.starting_time;
+    metrics->turnaround_time.record(waiting + runtime);
+    metrics->bounded_slowdown.record(
+        std::max(1.0, (waiting + runtime) / std::max(runtime, metrics->bounded_slowdown_threshold)));
+    metrics->busy_hosts -= job.nb_hosts;
+    metrics->jobs.erase(it);
+    metrics->nb_completed++;
+    metrics->last_completion = std::max(metrics->last_completion, now);
+}
+
+bool online_metrics_dump() {
+    if (!enabled || metrics == nullptr) {
+        return true;
+    }
+
+    const OnlineMetrics &m = *metrics;
+    // Integrals run up to the last completion, as Batsim's makespan does.
+    double makespan = m.last_completion;
+    double capacity = static_cast<double>(m.nb_hosts) * makespan;
+    uint64_t nb_allocations = m.nb_contiguous + m.nb_non_contiguous;
+
+    json report;
+    report["scheduler"] = m.scheduler;
+    report["jobs"] = {
+        {"submitted", m.nb_submitted},
+        {"rejected", m.nb_rejected},
+        {"started", m.nb_started},
+        {"completed", m.nb_completed},
+        {"still_waiting", m.waiting_jobs},
+        {"still_running", m.nb_started - m.nb_completed}};
+    report["makespan"] = makespan;
+    report["waiting_time"] = m.waiting_time.to_json();
+    report["turnaround_time"] = m.turnaround_time.to_json();
+    report["bounded_slowdown"] = m.bounded_slowdown.to_json();
+    report["bounded_slowdown"]["threshold"] = m.bounded_slowdown_threshold;
+    report["utilization"] = capacity > 0 ? m.busy_host_seconds / capacity : 0.0;
+    report["queue_length"] = {
+        {"mean", makespan > 0 ? m.queue_job_seconds / makespan : 0.0},
+        {"max", m.max_waiting_jobs},
+        {"integral", m.queue_job_seconds}};
+    report["contiguity"] = {
+        {"contiguous", m.nb_contiguous},
+        {"non_contiguous", m.nb_non_contiguous},
+        {"rate", nb_allocations == 0 ? 0.0 : static_cast<double>(m.nb_contiguous) / static_cast<double>(nb_allocations)}};
+
+    std::ofstream output(m.output_path, std::ios::out | std::ios::trunc);
+    metrics.reset();
+    enabled = false;
+    if (!output.is_open()) {
+        printf("Warning: Could not write the online metrics\n");
+        return false;
+    }
+    output << report.dump(2) << "\n";
+    return true;
+}
@@ -0,0 +1,44 @@
+// online_metrics.hpp
+//
+// Job metrics maintained by the schedulers while they run, so that a simulation can be summarized
+// without post-processing Batsim's CSV outputs. Every job is covered, not only the backfilled ones:
+//   - waiting time and bounded slowdown, as running sums and high-dynamic-range sketches,
+//   - time-weighted platform utilization and queue length (integrals over simulated time),
+//   - contiguity of every allocation.
+// The schedulers report submissions, rejections, starts and completions as they see them,
+// and online_metrics_dump(), called from batsim_edc_deinit(), writes the JSON summary.
+// Init data keys:
+//   "online_metrics": false                 disables the metrics
+//   "online_metrics_file": "<path>"         output file, "<scheduler>_online_metrics.json" by default
+//   "bounded_slowdown_threshold": <secs>    runtime floor of the bounded slowdown, 10 by default
+
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string>
+
+#include <intervalset.hpp>
+
+#include "edc_config.hpp"
+
+// Call once from batsim_edc_init(); resets everything recorded by a previous initialization.
+void online_metrics_init(const EdcConfig &config, const char *scheduler_name);
+
+// Writes the JSON summary (if enabled) and releases the recorded data. Call from batsim_edc_deinit().
+bool online_metrics_dump();
+
+void online_metrics_simulation_begins(double now, uint32_t nb_hosts);
+void online_metrics_job_submitted(const std::string &job_id, double now);
+void online_metrics_job_rejected(const std::string &job_id, double now);
+void online_metrics_job_started(const std::string &job_id, double now, uint32_t nb_hosts, bool contiguous);
+void online_metrics_job_completed(const std::string &job_id, double now);
+
+inline void online_metrics_job_started(const std::string &job_id, double now, const std::set<uint32_t> &hosts) {
+    bool contiguous = hosts.empty() || *hosts.rbegin() - *hosts.begin() + 1 == hosts.size();
+    online_metrics_job_started(job_id, now, static_cast<uint32_t>(hosts.size()), contiguous);
+}
+
+inline void online_metrics_job_started(const std::string &job_id, double now, const IntervalSet &hosts) {
+    online_metrics_job_started(job_id, now, hosts.size(), hosts.nb_intervals() <= 1);
+}
@@ -0,0 +1,154 @@
+// perf_counters.cpp
+//
+// perf_event_open based hardware counters, see perf_counters.hpp.
+
+#include "perf_counters.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char *counter_names[PERF_COUNTER_COUNT] = {"cycles", "instructions", "llc_misses", "branch_misses"};
+
+bool enabled = false;
+bool available[PERF_COUNTER_COUNT] = {false, false, false, false};
+
+#ifdef __linux__
+int group_fd = -1;
+int fds[PERF_COUNTER_COUNT] = {-1, -1, -1, -1};
+// Position of each opened counter in the group read buffer.
+int slot_of[PERF_COUNTER_COUNT] = {-1, -1, -1, -1};
+int nb_slots = 0;
+bool read_failure_reported = false;
+
+int open_counter(uint64_t config, int leader) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = (leader == -1) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0));
+}
+#endif
+
+} // namespace
+
+bool perf_counters_open() {
+    perf_counters_close();
+#ifdef __linux__
+    const uint64_t configs[PERF_COUNTER_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, // last level cache misses on most PMUs
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+    for (int counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+        int fd = open_counter(configs[counter], group_fd);
+        if (fd < 0) {
+            printf("Warning: perf counter '%s' is not available: %s\n", counter_names[counter], strerror(errno));
+            continue;
+        }
+        if (group_fd == -1) {
+            group_fd = fd;
+        }
+        fds[counter] = fd;
+        slot_of[counter] = nb_slots++;
+        available[counter] = true;
+    }
+    if (group_fd == -1) {
+        return false;
+    }
+    ioctl(group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    enabled = true;
+    return true;
+#else
+    printf("Warning: perf counters are only supported on Linux\n");
+    return false;
+#endif
+}
+
+void perf_counters_close() {
+#ifdef __linux__
+    for (int counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+        if (fds[counter] >= 0) {
+            close(fds[counter]);
+        }
+        fds[counter] = -1;
+        slot_of[counter] = -1;
+    }
+    group_fd = -1;
+    nb_slots = 0;
+    read_failure_reported = false;
+#endif
+    for (int counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+        available[counter] = false;
+    }
+    enabled = false;
+}
+
+bool perf_counters_enabled() {
+    return enabled;
+}
+
+bool perf_counter_available(PerfCounter counter) {
+    return available[counter];
+}
+
+const char *perf_counter_name(PerfCounter counter) {
+    return counter_names[counter];
+}
+
+bool perf_counters_read(uint64_t values[PERF_COUNTER_COUNT]) {
+#ifdef __linux__
+    if (!enabled) {
+        for (int counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+            values[counter] = 0;
+        }
+        return false;
+    }
+    // { nr, time_enabled, time_running, value[nr] }
+    uint64_t buffer[3 + PERF_COUNTER_COUNT];
+    ssize_t expected = static_cast<ssize_t>((3 + nb_slots) * sizeof(uint64_t));
+    ssize_t nb_read = read(group_fd, buffer, sizeof(buffer));
+    if (nb_read < expected) {
+        if (!read_failure_reported) {
+            printf("Warning: reading the perf counters failed (%s), the calls concerned are not counted\n",
+                   nb_read < 0 ? strerror(errno) : "short read");
+            read_failure_reported = true;
+        }
+        return false;
+    }
+    uint64_t time_enabled = buffer[1];
+    uint64_t time_running = buffer[2];
+    for (int counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+        uint64_t value = 0;
+        if (slot_of[counter] >= 0) {
+            value = buffer[3 + slot_of[counter]];
+            if (time_running > 0 && time_running < time_enabled) {
+                value = static_cast<uint64_t>(static_cast<double>(value) * time_enabled / time_running);
+            }
+        }
+        values[counter] = value;
+    }
+    return true;
+#else
+    for (int counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+        values[counter] = 0;
+    }
+    return false;
+#endif
+}
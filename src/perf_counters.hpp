@@ -0,0 +1,33 @@
+// perf_counters.hpp
+//
+// Optional hardware performance counters (Linux perf_event_open) for the decision instrumentation.
+// The counters are opened as one group on the calling thread, user space only, and read with a
+// single read() call, so that all of them cover exactly the same instructions.
+// If perf events are not available (other OS, perf_event_paranoid, container, no PMU...),
+// the counters that cannot be opened are reported as unavailable and everything else keeps working.
+
+#pragma once
+
+#include <cstdint>
+
+enum PerfCounter {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_COUNTER_COUNT
+};
+
+// Opens the counter group on the calling thread. Returns false if no counter could be opened.
+bool perf_counters_open();
+void perf_counters_close();
+
+bool perf_counters_enabled();
+bool perf_counter_available(PerfCounter counter);
+const char *perf_counter_name(PerfCounter counter);
+
+// Current values since perf_counters_open(), scaled if the kernel had to multiplex the group.
+// Unavailable counters read as 0. Returns false if the counters are not open (values are then
+// set to 0) or if the group could not be read (values are left unchanged, and a warning is
+// printed the first time). Scaled values are estimates: one may be lower than the previous one.
+bool perf_counters_read(uint64_t values[PERF_COUNTER_COUNT]);
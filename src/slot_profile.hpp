@@ -0,0 +1,231 @@
+// slot_profile.hpp
+//
+// Primitives shared by the time-aware backfilling schedulers (basic, best_cont, force_cont)
+// and benchmarked by src/tools/bench.cpp.
+// The availability profile is sliced in one-second slots: profile[t] is the set of hosts
+// that are free during second t. A job of walltime w started at t occupies slots [t, t + w).
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+typedef std::vector<std::set<uint32_t>> SlotProfile;
+
+// Makes sure slots 0..time exist, new slots having every host of the platform free.
+inline void ensure_time_slot_exists(SlotProfile &profile, double time, uint32_t nb_hosts) {
+    size_t time_index = static_cast<size_t>(time);
+
+    // If the time slot doesn't exist yet, create it and all slots up to it
+    while (profile.size() <= time_index) {
+        size_t new_index = profile.size();
+        profile.push_back(std::set<uint32_t>());
+
+        // Add all platform resources to the new time slot
+        for (uint32_t i = 0; i < nb_hosts; i++) {
+            profile[new_index].insert(i);
+        }
+    }
+}
+
+// Whether every host of hosts is free in every slot of [begin, end).
+inline bool window_is_free(const SlotProfile &profile, const std::set<uint32_t> &hosts, size_t begin, size_t end) {
+    for (size_t t = begin; t < end; ++t) {
+        for (uint32_t res : hosts) {
+            if (profile[t].find(res) == profile[t].end()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Marks hosts as used in every slot of [begin, end).
+inline void reserve_window(SlotProfile &profile, const std::set<uint32_t> &hosts, size_t begin, size_t end) {
+    for (size_t t = begin; t < end; ++t) {
+        for (uint32_t res : hosts) {
+            profile[t].erase(res);
+        }
+    }
+}
+
+// Marks hosts as free in every slot of [begin, end).
+inline void release_window(SlotProfile &profile, const std::set<uint32_t> &hosts, size_t begin, size_t end) {
+    for (size_t t = begin; t < end; ++t) {
+        for (uint32_t host : hosts) {
+            profile[t].insert(host);
+        }
+    }
+}
+
+// First run of nb_hosts consecutive host ids in available, in id order.
+// Returns false (run holding the partial last run) if there is none.
+inline bool find_contiguous_run(const std::set<uint32_t> &available, uint32_t nb_hosts, std::vector<uint32_t> &run) {
+    run.clear();
+    for (auto it = available.begin(); it != available.end(); ++it) {
+        if (!run.empty() && *it != run.back() + 1) {
+            // The host that breaks a run starts the next one
+            run.clear();
+        }
+        run.push_back(*it);
+        if (run.size() == nb_hosts) {
+            break;
+        }
+    }
+    return run.size() >= nb_hosts;
+}
+
+// How the contiguous schedulers choose among the runs of consecutive free hosts long enough:
+//   first_fit  the first run, in id order
+//   best_fit   the shortest run, which leaves the longer ones for larger jobs
+//   worst_fit  the longest run, which leaves the longest rest
+//   aligned    the first position aligned on the smallest power of two >= the job size, i.e. first
+//              fit restricted to aligned positions, which keeps the free hosts in aligned blocks;
+//              there are no buddy blocks to split or merge, and the hosts of the block the job
+//              does not use stay available to any job
+// The job takes the first hosts of the run (or of the block); ties go to the lowest ids.
+enum ContiguousPlacement {
+    PLACEMENT_FIRST_FIT = 0,
+    PLACEMENT_BEST_FIT,
+    PLACEMENT_WORST_FIT,
+    PLACEMENT_ALIGNED
+};
+
+// Sets hosts to nb_hosts consecutive host ids of available chosen by placement, in one pass over
+// available. Returns false (and clears hosts) if there are none.
+inline bool find_contiguous_hosts(const std::set<uint32_t> &available, uint32_t nb_hosts,
+                                  ContiguousPlacement placement, std::vector<uint32_t> &hosts) {
+    hosts.clear();
+    if (nb_hosts == 0 || available.size() < nb_hosts) {
+        return nb_hosts == 0;
+    }
+    uint32_t block = 1;
+    while (block < nb_hosts) {
+        block *= 2;
+    }
+    bool found = false;
+    uint32_t chosen = 0;        // First host of the chosen run (or block)
+    uint32_t chosen_length = 0;
+    // Looks at the run [begin, end) once it is complete, returns whether to stop there.
+    auto look_at_run = [&](uint32_t begin, uint32_t end) {
+        uint32_t length = end - begin;
+        if (length < nb_hosts) {
+            return false;
+        }
+        switch (placement) {
+            case PLACEMENT_FIRST_FIT:
+                chosen = begin;
+                found = true;
+                return true;
+            case PLACEMENT_BEST_FIT:
+                if (!found || length < chosen_length) {
+                    chosen = begin;
+                    chosen_length = length;
+                    found = true;
+                }
+                return length == nb_hosts;  // Cannot fit better
+            case PLACEMENT_WORST_FIT:
+                if (!found || length > chosen_length) {
+                    chosen = begin;
+                    chosen_length = length;
+                    found = true;
+                }
+                return false;
+            case PLACEMENT_ALIGNED: {
+                uint64_t aligned = (static_cast<uint64_t>(begin) + block - 1) / block * block;
+                if (aligned + nb_hosts <= end) {
+                    chosen = static_cast<uint32_t>(aligned);
+                    found = true;
+                    return true;
+                }
+                return false;
+            }
+        }
+        return false;
+    };
+    // First fit and aligned can stop as soon as the current run is long enough.
+    bool stops_early = (placement == PLACEMENT_FIRST_FIT || placement == PLACEMENT_ALIGNED);
+    bool stopped = false;
+    uint32_t begin = *available.begin();
+    uint32_t end = begin;
+    for (uint32_t host : available) {
+        if (host != end) {
+            if (look_at_run(begin, end)) {
+                stopped = true;
+                break;
+            }
+            begin = host;
+        }
+        end = host + 1;
+        if (stops_early && look_at_run(begin, end)) {
+            stopped = true;
+            break;
+        }
+    }
+    if (!stopped) {
+        look_at_run(begin, end);
+    }
+    if (!found) {
+        return false;
+    }
+    for (uint32_t host = chosen; host < chosen + nb_hosts; ++host) {
+        hosts.push_back(host);
+    }
+    return true;
+}
+
+// Sets hosts to the hosts free at time_index that stay free during the window the contiguous
+// schedulers check before backfilling a job of this walltime, and returns whether the check reached
+// the walltime.
+// Note: the check adds the slot offsets up (0 + 1 + 2 + ...) instead of counting the slots, so it
+// only looks at about sqrt(2 * walltime) slots, which is how these schedulers have always backfilled.
+// Slots up to time_index + walltime must exist.
+inline bool backfill_window_hosts(const SlotProfile &profile, size_t time_index, uint32_t walltime,
+                                  std::set<uint32_t> &hosts) {
+    hosts = profile[time_index];
+    uint32_t time = 0;
+    for (size_t t = time_index; t < time_index + walltime; ++t) {
+        std::set<uint32_t> intersection;
+        std::set_intersection(hosts.begin(), hosts.end(), profile[t].begin(), profile[t].end(),
+                              std::inserter(intersection, intersection.begin()));
+        hosts.swap(intersection);
+        time = time + (t - time_index);
+        if (time >= walltime) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// What the backfilling loops of the contiguous schedulers need to know about a waiting job.
+// Computing it only reads the profile, so the candidates can be evaluated in parallel.
+struct BackfillCandidate {
+    bool fits_now = false;         // Enough hosts free at time_index, nothing else is set otherwise
+    bool window_checked = false;   // What backfill_window_hosts() returned
+    std::set<uint32_t> hosts;      // Set by backfill_window_hosts()
+    std::vector<uint32_t> run;     // Contiguous hosts among hosts, found by the scheduler
+};
+
+inline void evaluate_backfill_candidate(const SlotProfile &profile, size_t time_index, uint32_t nb_hosts,
+                                        uint32_t walltime, BackfillCandidate &candidate) {
+    candidate.fits_now = profile[time_index].size() >= nb_hosts;
+    if (!candidate.fits_now) {
+        return;
+    }
+    candidate.window_checked = backfill_window_hosts(profile, time_index, walltime, candidate.hosts);
+}
+
+// Comma-separated list of host ids, as given to add_execute_job().
+inline std::string format_resources(const std::set<uint32_t> &hosts) {
+    std::string resources_str;
+    for (auto it = hosts.begin(); it != hosts.end(); ++it) {
+        if (it != hosts.begin())
+            resources_str += ",";
+        resources_str += std::to_string(*it);
+    }
+    return resources_str;
+}
@@ -0,0 +1,181 @@
+// thread_pool.hpp
+//
+// A small work-stealing thread pool.
+// Each worker owns a deque of tasks: it pops from the back of its own deque
+// and, when that is empty, steals from the front of the other workers' deques.
+// Tasks submitted from outside the pool are spread round-robin over the workers,
+// tasks submitted from inside a worker go to that worker's own deque.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    // Most workers worth asking for: beyond a few per hardware thread, they only contend.
+    static unsigned max_threads() { return 4 * std::max(1u, std::thread::hardware_concurrency()); }
+
+    // nb_threads == 0 means one worker per hardware thread.
+    explicit ThreadPool(unsigned nb_threads = 0) {
+        if (nb_threads == 0) {
+            nb_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (unsigned i = 0; i < nb_threads; ++i) {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+        for (unsigned i = 0; i < nb_threads; ++i) {
+            threads_.emplace_back([this, i]() { worker_loop(i); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            stop_ = true;
+        }
+        wake_cv_.notify_all();
+        for (auto & thread : threads_) {
+            thread.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool & operator=(const ThreadPool &) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+    // Index of the pool worker running the calling thread, -1 outside of any pool.
+    static int current_worker() { return worker_index(); }
+
+    void submit(std::function<void()> task) {
+        int self = worker_index();
+        size_t target = (self >= 0 && owner() == this)
+            ? static_cast<size_t>(self)
+            : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+
+        pending_.fetch_add(1, std::memory_order_acq_rel);
+        {
+            std::lock_guard<std::mutex> lock(workers_[target]->mutex);
+            workers_[target]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            queued_++;
+        }
+        wake_cv_.notify_one();
+    }
+
+    // Blocks until every submitted task has finished running. Must not be called from a worker.
+    void wait_idle() {
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        idle_cv_.wait(lock, [this]() { return pending_.load(std::memory_order_acquire) == 0; });
+    }
+
+    // Runs body(i) for every i in [0, count) on the workers, each one taking the next index when it
+    // is done with the previous one, and returns when all are done. Must not be called from a worker.
+    template <typename Body>
+    void parallel_for(size_t count, Body body) {
+        std::atomic<size_t> next{0};
+        size_t nb_tasks = std::min(count, workers_.size());
+        for (size_t i = 0; i < nb_tasks; ++i) {
+            submit([&next, &body, count]() {
+                for (size_t index = next.fetch_add(1, std::memory_order_relaxed); index < count;
+                     index = next.fetch_add(1, std::memory_order_relaxed)) {
+                    body(index);
+                }
+            });
+        }
+        wait_idle();
+    }
+
+private:
+    struct Worker {
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+    };
+
+    static int & worker_index() {
+        static thread_local int index = -1;
+        return index;
+    }
+
+    static ThreadPool *& owner() {
+        static thread_local ThreadPool * pool = nullptr;
+        return pool;
+    }
+
+    bool pop_task(size_t self, std::function<void()> & task) {
+        {
+            // Own deque: newest task first, it is the most likely to be cache-hot.
+            std::lock_guard<std::mutex> lock(workers_[self]->mutex);
+            if (!workers_[self]->tasks.empty()) {
+                task = std::move(workers_[self]->tasks.back());
+                workers_[self]->tasks.pop_back();
+                return true;
+            }
+        }
+        // Steal the oldest task of another worker.
+        for (size_t offset = 1; offset < workers_.size(); ++offset) {
+            size_t victim = (self + offset) % workers_.size();
+            std::lock_guard<std::mutex> lock(workers_[victim]->mutex);
+            if (!workers_[victim]->tasks.empty()) {
+                task = std::move(workers_[victim]->tasks.front());
+                workers_[victim]->tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker_loop(size_t self) {
+        worker_index() = static_cast<int>(self);
+        owner() = this;
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(wake_mutex_);
+                wake_cv_.wait(lock, [this]() { return stop_ || queued_ > 0; });
+                if (stop_ && queued_ == 0) {
+                    return;
+                }
+                // Claim one queued task: there is now at least one task left for us in some deque.
+                queued_--;
+            }
+
+            std::function<void()> task;
+            while (!pop_task(self, task)) {
+                // The claimed task was pushed to a deque we already scanned, go round again.
+                std::this_thread::yield();
+            }
+
+            task();
+
+            if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(idle_mutex_);
+                idle_cv_.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> next_worker_{0};
+    std::atomic<size_t> pending_{0}; // submitted but not finished
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    size_t queued_ = 0;              // queued and not claimed yet, protected by wake_mutex_
+    bool stop_ = false;
+
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+};
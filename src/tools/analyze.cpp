@@ -0,0 +1,304 @@
+// analyze.cpp
+//
+// Native replacement for the summary part of scripts/analyze_scheduler_performance.py.
+// out/jobs.csv and out/schedule.csv (Batsim outputs) are mapped with mmap and parsed in a single pass:
+// lines and fields are split with memchr, which glibc vectorizes, and every column is reduced on the fly
+// (sums, resource counts, and LogHistogram sketches for the percentiles), so memory does not grow
+// with the number of jobs.
+//
+// Writes <output_dir>/<algorithm>_performance_summary.txt with the same layout as the Python script,
+// and <output_dir>/<algorithm>_percentiles.txt with the percentiles and the contiguity rate of the
+// allocations. The plots are still made by the Python script.
+//
+// Usage: analyze <algorithm> [output_dir] [--input-dir out]
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../log_histogram.hpp"
+#include "csv_reader.hpp"
+
+// Mean of a column, skipping missing values like pandas' mean().
+struct ColumnMean {
+    long double sum = 0;
+    uint64_t count = 0;
+
+    void add(double value) {
+        sum += value;
+        count++;
+    }
+    double mean() const { return count == 0 ? NAN : static_cast<double>(sum / count); }
+};
+
+// Percentiles of non-negative values, kept with millisecond (or thousandth) resolution.
+struct ValueSketch {
+    LogHistogram histogram;
+    double max = 0;
+
+    void add(double value) {
+        histogram.record(static_cast<uint64_t>(std::max(0.0, value) * 1000.0 + 0.5));
+        max = std::max(max, value);
+    }
+    double quantile(double q) const { return histogram.quantile(q) / 1000.0; }
+};
+
+// An allocation is contiguous when it is a single interval: "3" or "0-3", not "0-1 4" nor "0 2".
+static bool is_contiguous(std::string_view allocation) {
+    if (allocation.size() >= 2 && allocation.front() == '"' && allocation.back() == '"') {
+        allocation = allocation.substr(1, allocation.size() - 2);
+    }
+    while (!allocation.empty() && allocation.back() == ' ') {
+        allocation.remove_suffix(1);
+    }
+    return allocation.find_first_of(" ,") == std::string_view::npos;
+}
+
+struct JobsSummary {
+    uint64_t total_jobs = 0;
+    ColumnMean resources;
+    ColumnMean execution_time;
+    ColumnMean waiting_time;
+    ColumnMean stretch;
+    std::map<int64_t, uint64_t> resource_counts;
+    ValueSketch waiting_sketch;
+    ValueSketch turnaround_sketch;
+    ValueSketch stretch_sketch;
+    ValueSketch bounded_slowdown_sketch;
+    uint64_t allocated_jobs = 0;
+    uint64_t contiguous_jobs = 0;
+};
+
+static bool analyze_jobs(std::string_view text, JobsSummary &summary, std::string &error) {
+    CsvReader reader(text);
+    std::vector<std::string_view> header, fields;
+    if (!reader.next_line(header)) {
+        error = "jobs.csv is empty";
+        return false;
+    }
+    int resources_column = column(header, "requested_number_of_resources");
+    int execution_column = column(header, "execution_time");
+    int waiting_column = column(header, "waiting_time");
+    int turnaround_column = column(header, "turnaround_time");
+    int stretch_column = column(header, "stretch");
+    int allocation_column = column(header, "allocated_resources");
+    if (resources_column < 0 || execution_column < 0 || waiting_column < 0 || stretch_column < 0) {
+        error = "jobs.csv misses one of the requested_number_of_resources, execution_time, waiting_time "
+                "and stretch columns";
+        return false;
+    }
+
+    while (reader.next_line(fields)) {
+        if (fields.size() == 1 && fields[0].empty()) {
+            continue;  // trailing empty line
+        }
+        summary.total_jobs++;
+        double resources = 0, execution = 0, waiting = 0, turnaround = 0, stretch = 0;
+        if (parse_number(fields, resources_column, resources)) {
+            summary.resources.add(resources);
+            summary.resource_counts[static_cast<int64_t>(resources)]++;
+        }
+        bool has_execution = parse_number(fields, execution_column, execution);
+        if (has_execution) {
+            summary.execution_time.add(execution);
+        }
+        if (parse_number(fields, waiting_column, waiting)) {
+            summary.waiting_time.add(waiting);
+            summary.waiting_sketch.add(waiting);
+        }
+        if (parse_number(fields, stretch_column, stretch)) {
+            summary.stretch.add(stretch);
+            summary.stretch_sketch.add(stretch);
+        }
+        if (parse_number(fields, turnaround_column, turnaround)) {
+            summary.turnaround_sketch.add(turnaround);
+            if (has_execution) {
+                // Bounded slowdown with the usual 10 seconds threshold.
+                summary.bounded_slowdown_sketch.add(std::max(1.0, turnaround / std::max(execution, 10.0)));
+            }
+        }
+        if (allocation_column >= 0 && static_cast<size_t>(allocation_column) < fields.size()
+            && !fields[allocation_column].empty()) {
+            summary.allocated_jobs++;
+            if (is_contiguous(fields[allocation_column])) {
+                summary.contiguous_jobs++;
+            }
+        }
+    }
+    return true;
+}
+
+// schedule.csv has a header and a single line of values.
+static bool read_schedule(std::string_view text, std::map<std::string, double> &values, std::string &error) {
+    CsvReader reader(text);
+    std::vector<std::string_view> header, fields;
+    if (!reader.next_line(header) || !reader.next_line(fields)) {
+        error = "schedule.csv has no data line";
+        return false;
+    }
+    for (size_t i = 0; i < header.size() && i < fields.size(); ++i) {
+        double value;
+        if (parse_number(fields, static_cast<int>(i), value)) {
+            values[std::string(header[i])] = value;
+        }
+    }
+    for (const char *name : {"makespan", "mean_waiting_time", "mean_turnaround_time", "mean_slowdown", "max_slowdown",
+                             "time_computing", "nb_computing_machines"}) {
+        if (values.count(name) == 0) {
+            error = std::string("schedule.csv has no '") + name + "' value";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Same as extract_backfill_stats() in the Python script: the last line of the log, if any.
+static bool extract_backfill_stats(const std::string &log_path, long long stats[3]) {
+    MappedFile log;
+    if (!log.open(log_path)) {
+        return false;
+    }
+    std::string_view text = log.content();
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+    size_t begin = text.rfind('\n');
+    std::string last(text.substr(begin == std::string_view::npos ? 0 : begin + 1));
+    return sscanf(last.c_str(), "%lld %lld %lld", &stats[0], &stats[1], &stats[2]) == 3;
+}
+
+// The summary, in the layout of the Python script. The same text goes to stdout and to the file,
+// except the backfill statistics that the script only prints.
+static std::string format_summary(const JobsSummary &jobs, std::map<std::string, double> &schedule,
+                                  const long long *backfill) {
+    std::string text;
+    char line[256];
+    auto add = [&](const char *format, auto... values) {
+        snprintf(line, sizeof(line), format, values...);
+        text += line;
+    };
+
+    add("=== SCHEDULER PERFORMANCE SUMMARY ===\n");
+    add("Total Jobs: %" PRIu64 "\n", jobs.total_jobs);
+    add("Makespan: %.2f seconds\n", schedule["makespan"]);
+    add("Mean Waiting Time: %.2f seconds\n", schedule["mean_waiting_time"]);
+    add("Mean Turnaround Time: %.2f seconds\n", schedule["mean_turnaround_time"]);
+    add("Mean Slowdown: %.2f\n", schedule["mean_slowdown"]);
+    add("Max Slowdown: %.2f\n", schedule["max_slowdown"]);
+    if (backfill != nullptr) {
+        add("\nBackfill Statistics:\n");
+        add("Total Backfills: %lld\n", backfill[0]);
+        add("Contiguous Backfills: %lld\n", backfill[1]);
+        add("Basic Backfills: %lld\n", backfill[2]);
+    }
+    double utilization = schedule["time_computing"] / (schedule["makespan"] * schedule["nb_computing_machines"]) * 100;
+    add("\nResource Utilization: %.2f%%\n", utilization);
+    add("\n=== JOB CHARACTERISTICS ===\n");
+    add("Average Resources per Job: %.2f\n", jobs.resources.mean());
+    add("Average Execution Time: %.2f seconds\n", jobs.execution_time.mean());
+    add("Average Waiting Time: %.2f seconds\n", jobs.waiting_time.mean());
+    add("Average Stretch: %.2f\n", jobs.stretch.mean());
+    add("\nResource Request Distribution:\n");
+    for (const auto &entry : jobs.resource_counts) {
+        add("  %" PRId64 " resources: %" PRIu64 " jobs (%.1f%%)\n", entry.first, entry.second,
+            static_cast<double>(entry.second) / jobs.total_jobs * 100);
+    }
+    return text;
+}
+
+static std::string format_percentiles(const JobsSummary &jobs) {
+    std::string text = "=== PERCENTILES (streaming sketch, ~3% relative error) ===\n";
+    char line[256];
+    auto add = [&](const char *name, const ValueSketch &sketch, const char *unit) {
+        snprintf(line, sizeof(line), "%s: p50 %.2f, p90 %.2f, p99 %.2f, max %.2f%s\n", name, sketch.quantile(0.5),
+                 sketch.quantile(0.9), sketch.quantile(0.99), sketch.max, unit);
+        text += line;
+    };
+    add("Waiting Time", jobs.waiting_sketch, " seconds");
+    add("Turnaround Time", jobs.turnaround_sketch, " seconds");
+    add("Stretch", jobs.stretch_sketch, "");
+    add("Bounded Slowdown (10 s)", jobs.bounded_slowdown_sketch, "");
+
+    text += "\n=== CONTIGUITY ===\n";
+    snprintf(line, sizeof(line), "Contiguous Allocations: %" PRIu64 " of %" PRIu64 " jobs (%.1f%%)\n",
+             jobs.contiguous_jobs, jobs.allocated_jobs,
+             jobs.allocated_jobs == 0 ? 0.0 : static_cast<double>(jobs.contiguous_jobs) / jobs.allocated_jobs * 100);
+    text += line;
+    return text;
+}
+
+static bool write_file(const std::string &path, const std::string &text) {
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+    return (fclose(file) == 0) && ok;
+}
+
+int main(int argc, char **argv) {
+    std::vector<std::string> positional;
+    std::string input_dir = "./out";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--input-dir" && i + 1 < argc) {
+            input_dir = argv[++i];
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.empty() || positional.size() > 2) {
+        printf("Usage: %s <algorithm_name> [output_dir] [--input-dir out]\n", argv[0]);
+        printf("Example: %s basic res/basic_1000_5\n", argv[0]);
+        return 1;
+    }
+    const std::string &algorithm = positional[0];
+    std::string output_dir = positional.size() > 1 ? positional[1] : "res/" + algorithm;
+    std::string output_prefix = output_dir + "/" + algorithm;
+
+    std::string jobs_path = input_dir + "/jobs.csv";
+    std::string schedule_path = input_dir + "/schedule.csv";
+    MappedFile jobs_file, schedule_file;
+    if (!jobs_file.open(jobs_path)) {
+        printf("Error: Input file '%s' not found.\n", jobs_path.c_str());
+        return 1;
+    }
+    if (!schedule_file.open(schedule_path)) {
+        printf("Error: Input file '%s' not found.\n", schedule_path.c_str());
+        return 1;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(output_dir, ec);
+
+    std::string error;
+    JobsSummary jobs;
+    std::map<std::string, double> schedule;
+    if (!analyze_jobs(jobs_file.content(), jobs, error) || !read_schedule(schedule_file.content(), schedule, error)) {
+        printf("Error: %s\n", error.c_str());
+        return 1;
+    }
+
+    long long backfill[3] = {0, 0, 0};
+    if (!extract_backfill_stats(input_dir + "/" + algorithm + "_log.txt", backfill)) {
+        backfill[0] = backfill[1] = backfill[2] = 0;
+    }
+
+    std::string percentiles = format_percentiles(jobs);
+    printf("\n%s\n%s", format_summary(jobs, schedule, backfill).c_str(), percentiles.c_str());
+
+    if (!write_file(output_prefix + "_performance_summary.txt", format_summary(jobs, schedule, nullptr))
+        || !write_file(output_prefix + "_percentiles.txt", percentiles)) {
+        printf("Error: cannot write the results in %s\n", output_dir.c_str());
+        return 1;
+    }
+    printf("\nAnalysis complete. Results saved to %s\n", output_dir.c_str());
+    return 0;
+}
@@ -0,0 +1,337 @@
+// bench.cpp
+//
+// Microbenchmarks of the primitives the schedulers spend their decisions in (slot_profile.hpp and
+// the pending queue, as a list or as an indexed heap), over platform sizes from 16 to 128k hosts and walltimes from 10 seconds to a week.
+// Every result is printed as one JSON object per line:
+//   {"bench": "window_is_free", "hosts": 1024, "walltime": 3600, "job_hosts": 64,
+//    "iterations": 1234, "ns_per_op": 56789.0, "status": "ok"}
+// Jobs request hosts / 16 hosts. Benchmarks that do not depend on the walltime report it as null.
+// A point whose profile would not fit in --max-profile-bytes, or whose single operation would
+// exceed --max-work elementary steps, is reported with "status": "skipped" and the reason.
+//
+// Usage: bench [--filter substring] [--min-time seconds] [--max-profile-bytes n] [--max-work n]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <list>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../indexed_heap.hpp"
+#include "../slot_profile.hpp"
+
+struct BenchOptions {
+    std::string filter;
+    double min_time = 0.2;
+    uint64_t max_profile_bytes = uint64_t(1) << 30;
+    uint64_t max_work = 100000000;
+};
+
+struct BenchPoint {
+    const char *bench;
+    uint32_t hosts;
+    uint32_t walltime;      // 0 if the benchmark does not depend on it
+    uint32_t job_hosts;
+};
+
+static const uint32_t host_counts[] = {16, 128, 1024, 8192, 32768, 131072};
+static const uint32_t walltimes[] = {10, 3600, 86400, 604800};
+
+// Pending job as stored by the schedulers.
+struct QueuedJob {
+    std::string job_id;
+    uint8_t nb_hosts;
+    uint32_t walltime;
+};
+
+// Keeps the optimizer from removing the benchmarked work.
+static volatile uint64_t sink;
+
+static bool selected(const BenchOptions &options, const char *bench) {
+    return options.filter.empty() || std::string(bench).find(options.filter) != std::string::npos;
+}
+
+static void print_point(const BenchPoint &point) {
+    printf("{\"bench\": \"%s\", \"hosts\": %u, ", point.bench, point.hosts);
+    if (point.walltime > 0) {
+        printf("\"walltime\": %u, ", point.walltime);
+    } else {
+        printf("\"walltime\": null, ");
+    }
+    printf("\"job_hosts\": %u, ", point.job_hosts);
+}
+
+static void report_skipped(const BenchPoint &point, const char *reason) {
+    print_point(point);
+    printf("\"iterations\": 0, \"ns_per_op\": null, \"status\": \"skipped\", \"reason\": \"%s\"}\n", reason);
+    fflush(stdout);
+}
+
+// Runs op until min_time has elapsed (at least once) and reports the mean time per call.
+static void run(const BenchOptions &options, const BenchPoint &point, const std::function<void()> &op) {
+    using clock = std::chrono::steady_clock;
+    uint64_t iterations = 0;
+    auto begin = clock::now();
+    double elapsed = 0;
+    do {
+        op();
+        iterations++;
+        elapsed = std::chrono::duration<double>(clock::now() - begin).count();
+    } while (elapsed < options.min_time);
+
+    print_point(point);
+    printf("\"iterations\": %llu, \"ns_per_op\": %.1f, \"status\": \"ok\"}\n",
+           static_cast<unsigned long long>(iterations), elapsed * 1e9 / static_cast<double>(iterations));
+    fflush(stdout);
+}
+
+// Approximate footprint of a profile: one red-black tree node per free host per slot.
+static uint64_t profile_bytes(uint32_t hosts, uint32_t walltime) {
+    const uint64_t node_bytes = 40, set_bytes = sizeof(std::set<uint32_t>);
+    return (static_cast<uint64_t>(walltime) + 1) * (set_bytes + node_bytes * hosts);
+}
+
+static void bench_profile(const BenchOptions &options, uint32_t hosts, uint32_t walltime) {
+    uint32_t job_hosts = std::max(1u, hosts / 16);
+    BenchPoint build = {"ensure_time_slot_exists", hosts, walltime, job_hosts};
+    BenchPoint window = {"window_is_free", hosts, walltime, job_hosts};
+    BenchPoint reserve = {"reserve_release_window", hosts, walltime, job_hosts};
+    bool want_build = selected(options, build.bench);
+    bool want_window = selected(options, window.bench);
+    bool want_reserve = selected(options, reserve.bench);
+    if (!want_build && !want_window && !want_reserve) {
+        return;
+    }
+
+    if (profile_bytes(hosts, walltime) > options.max_profile_bytes) {
+        for (const BenchPoint &point : {build, window, reserve}) {
+            if (selected(options, point.bench)) {
+                report_skipped(point, "profile exceeds --max-profile-bytes");
+            }
+        }
+        return;
+    }
+
+    // Building the whole profile is the benchmark of ensure_time_slot_exists, timed once.
+    auto begin = std::chrono::steady_clock::now();
+    SlotProfile profile;
+    ensure_time_slot_exists(profile, walltime, hosts);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    if (want_build) {
+        print_point(build);
+        printf("\"iterations\": 1, \"ns_per_op\": %.1f, \"status\": \"ok\"}\n", elapsed * 1e9);
+        fflush(stdout);
+    }
+
+    // The job takes the last hosts, which is the worst case of the lookups in every slot.
+    std::set<uint32_t> job;
+    for (uint32_t host = hosts - job_hosts; host < hosts; ++host) {
+        job.insert(host);
+    }
+    uint64_t work = static_cast<uint64_t>(walltime) * job_hosts;
+
+    if (want_window) {
+        if (work > options.max_work) {
+            report_skipped(window, "operation exceeds --max-work");
+        } else {
+            run(options, window, [&]() { sink = window_is_free(profile, job, 0, walltime); });
+        }
+    }
+    if (want_reserve) {
+        if (2 * work > options.max_work) {
+            report_skipped(reserve, "operation exceeds --max-work");
+        } else {
+            run(options, reserve, [&]() {
+                reserve_window(profile, job, 0, walltime);
+                release_window(profile, job, 0, walltime);
+            });
+        }
+    }
+}
+
+static void bench_slot(const BenchOptions &options, uint32_t hosts) {
+    uint32_t job_hosts = std::max(1u, hosts / 16);
+
+    // Every job_hosts-th host is busy so no run is ever long enough: the search scans the whole slot.
+    BenchPoint search = {"find_contiguous_run", hosts, 0, job_hosts};
+    if (selected(options, search.bench)) {
+        std::set<uint32_t> fragmented;
+        for (uint32_t host = 0; host < hosts; ++host) {
+            if (host % job_hosts != 0 || job_hosts == 1) {
+                fragmented.insert(host);
+            }
+        }
+        std::vector<uint32_t> found;
+        found.reserve(job_hosts);
+        run(options, search, [&]() { sink = find_contiguous_run(fragmented, job_hosts, found); });
+    }
+
+    // Best fit looks at every run: here the only one long enough is the last one.
+    BenchPoint best_fit = {"find_contiguous_best_fit", hosts, 0, job_hosts};
+    if (selected(options, best_fit.bench)) {
+        std::set<uint32_t> fragmented;
+        for (uint32_t host = 0; host < hosts; ++host) {
+            if (host % job_hosts != 0 || job_hosts == 1 || host + job_hosts >= hosts) {
+                fragmented.insert(host);
+            }
+        }
+        std::vector<uint32_t> found;
+        found.reserve(job_hosts);
+        run(options, best_fit, [&]() { sink = find_contiguous_hosts(fragmented, job_hosts, PLACEMENT_BEST_FIT, found); });
+    }
+
+    // Aligned placement on the same hosts: the only aligned position with a long enough run is the last one.
+    BenchPoint aligned = {"find_contiguous_aligned", hosts, 0, job_hosts};
+    if (selected(options, aligned.bench)) {
+        std::set<uint32_t> fragmented;
+        for (uint32_t host = 0; host < hosts; ++host) {
+            if (host % job_hosts != 0 || job_hosts == 1 || host + job_hosts >= hosts) {
+                fragmented.insert(host);
+            }
+        }
+        std::vector<uint32_t> found;
+        found.reserve(job_hosts);
+        run(options, aligned, [&]() { sink = find_contiguous_hosts(fragmented, job_hosts, PLACEMENT_ALIGNED, found); });
+    }
+
+    BenchPoint format = {"format_resources", hosts, 0, job_hosts};
+    if (selected(options, format.bench)) {
+        std::set<uint32_t> allocation;
+        for (uint32_t host = hosts - job_hosts; host < hosts; ++host) {
+            allocation.insert(host);
+        }
+        run(options, format, [&]() { sink = format_resources(allocation).size(); });
+    }
+}
+
+// The queue benchmarks use the host counts as queue lengths ("hosts" is the number of queued jobs).
+static void bench_queue(const BenchOptions &options, uint32_t length) {
+    std::list<QueuedJob *> queue;
+    std::vector<QueuedJob> storage(length + 1);
+    for (uint32_t i = 0; i <= length; ++i) {
+        storage[i].job_id = "w0!" + std::to_string(i);
+        storage[i].nb_hosts = static_cast<uint8_t>(1 + i % 3);
+        storage[i].walltime = 5 + i % 26;
+    }
+    for (uint32_t i = 0; i < length; ++i) {
+        queue.push_back(&storage[i]);
+    }
+
+    // Submission of a job at the tail, and removal of a job from the middle of the queue once backfilled.
+    BenchPoint insert = {"queue_insert_erase", length, 0, 0};
+    if (selected(options, insert.bench)) {
+        auto middle = std::next(queue.begin(), length / 2);
+        run(options, insert, [&]() {
+            queue.push_back(&storage[length]);
+            queue.erase(std::prev(queue.end()));
+            queue.erase(queue.insert(middle, &storage[length]));
+        });
+    }
+
+    // A backfilling pass that finds no candidate: every pending job is looked at.
+    BenchPoint scan = {"queue_scan", length, 0, 0};
+    if (selected(options, scan.bench)) {
+        run(options, scan, [&]() {
+            uint64_t candidates = 0;
+            for (auto it = std::next(queue.begin()); it != queue.end(); ++it) {
+                if ((*it)->nb_hosts > 3) {
+                    break;
+                }
+                candidates++;
+            }
+            sink = candidates;
+        });
+    }
+
+    // The same queue ordered by priority in an indexed heap (easy_backfill with "priority").
+    typedef IndexedHeap<QueuedJob *, std::pair<double, uint64_t>> Heap;
+    Heap heap;
+    for (uint32_t i = 0; i < length; ++i) {
+        heap.push(&storage[i], std::make_pair(static_cast<double>(storage[i].walltime), uint64_t(i)));
+    }
+
+    // Refresh of every key (easy_backfill with "priority": "wfp"), then the walk that sorts them again.
+    BenchPoint rekey = {"heap_rekey", length, 0, 0};
+    if (selected(options, rekey.bench)) {
+        uint64_t step = 0;
+        run(options, rekey, [&]() {
+            step++;
+            heap.rekey([step](QueuedJob *job) {
+                return std::make_pair(static_cast<double>((job->walltime * step) % 31), uint64_t(job->nb_hosts));
+            });
+            uint64_t candidates = 0;
+            heap.visit_in_order([&](Heap::Handle, QueuedJob *job) {
+                candidates += job->nb_hosts;
+                return true;
+            });
+            sink = candidates;
+        });
+    }
+
+    // Submission of a job, then its start (from anywhere in the queue).
+    BenchPoint push_erase = {"heap_push_erase", length, 0, 0};
+    if (selected(options, push_erase.bench)) {
+        run(options, push_erase, [&]() {
+            heap.erase(heap.push(&storage[length], std::make_pair(15.0, uint64_t(length))));
+        });
+    }
+
+    // A backfilling pass over the whole queue after a submission and a start, as in a decision call.
+    BenchPoint heap_scan = {"heap_scan", length, 0, 0};
+    if (selected(options, heap_scan.bench)) {
+        run(options, heap_scan, [&]() {
+            heap.erase(heap.push(&storage[length], std::make_pair(15.0, uint64_t(length))));
+            Heap::Handle pushed = heap.push(&storage[length], std::make_pair(16.0, uint64_t(length)));
+            uint64_t candidates = 0;
+            heap.visit_in_order([&](Heap::Handle, QueuedJob *job) {
+                candidates += job->nb_hosts;
+                return true;
+            });
+            heap.erase(pushed);
+            sink = candidates;
+        });
+    }
+}
+
+static void print_usage(const char *program) {
+    printf("Usage: %s [--filter substring] [--min-time seconds] [--max-profile-bytes n] [--max-work n]\n", program);
+}
+
+int main(int argc, char **argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help" || i + 1 >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--filter") {
+            options.filter = value;
+        } else if (arg == "--min-time") {
+            options.min_time = std::stod(value);
+        } else if (arg == "--max-profile-bytes") {
+            options.max_profile_bytes = std::stoull(value);
+        } else if (arg == "--max-work") {
+            options.max_work = std::stoull(value);
+        } else {
+            printf("Unknown option '%s'\n", arg.c_str());
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    for (uint32_t hosts : host_counts) {
+        for (uint32_t walltime : walltimes) {
+            bench_profile(options, hosts, walltime);
+        }
+        bench_slot(options, hosts);
+        bench_queue(options, hosts);
+    }
+    return 0;
+}
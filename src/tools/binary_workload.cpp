@@ -0,0 +1,231 @@
+// binary_workload.cpp
+//
+// Writing and mapping of columnar binary workloads, see binary_workload.hpp.
+
+#include "binary_workload.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char workload_magic[8] = {'R', 'M', 'S', 'E', 'W', 'K', 'L', '1'};
+
+uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~uint64_t(7);
+}
+
+// Appends a section at the next 8-byte boundary and returns its offset.
+uint64_t write_section(FILE *file, uint64_t &offset, const void *data, uint64_t size) {
+    static const char padding[8] = {0};
+    uint64_t aligned = align8(offset);
+    fwrite(padding, 1, aligned - offset, file);
+    if (size > 0) {
+        fwrite(data, 1, size, file);
+    }
+    offset = aligned + size;
+    return aligned;
+}
+
+} // namespace
+
+bool is_binary_workload(const std::string &path) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    char magic[sizeof(workload_magic)];
+    bool binary = fread(magic, 1, sizeof(magic), file) == sizeof(magic)
+        && memcmp(magic, workload_magic, sizeof(magic)) == 0;
+    fclose(file);
+    return binary;
+}
+
+// -------------------------
+// Writer
+// -------------------------
+uint32_t BinaryWorkloadWriter::profile_index(std::string_view profile) {
+    auto it = profile_indexes_.find(std::string(profile));
+    if (it != profile_indexes_.end()) {
+        return it->second;
+    }
+    uint32_t index = static_cast<uint32_t>(profile_names_.size());
+    profile_names_.emplace_back(profile);
+    profile_delays_.push_back(-1);
+    profile_indexes_.emplace(std::string(profile), index);
+    return index;
+}
+
+void BinaryWorkloadWriter::add_job(std::string_view id, std::string_view profile, double subtime,
+                                   uint32_t res, double walltime) {
+    subtimes_.push_back(subtime);
+    walltimes_.push_back(walltime);
+    res_.push_back(res);
+    profiles_.push_back(profile_index(profile));
+    id_chars_.append(id.data(), id.size());
+    id_offsets_.push_back(id_chars_.size());
+}
+
+void BinaryWorkloadWriter::set_profile_delay(std::string_view profile, double delay) {
+    profile_delays_[profile_index(profile)] = delay;
+}
+
+bool BinaryWorkloadWriter::write(const std::string &path, std::string &error) const {
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        error = "cannot open '" + path + "' for writing";
+        return false;
+    }
+
+    std::vector<uint64_t> name_offsets = {0};
+    std::string name_chars;
+    for (const std::string &name : profile_names_) {
+        name_chars += name;
+        name_offsets.push_back(name_chars.size());
+    }
+
+    BinaryWorkloadHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, workload_magic, sizeof(header.magic));
+    header.nb_res = nb_res_;
+    header.nb_jobs = subtimes_.size();
+    header.nb_profiles = profile_names_.size();
+
+    // The header is written twice: once to reserve its room, once the offsets are known.
+    uint64_t offset = 0;
+    write_section(file, offset, &header, sizeof(header));
+    header.description_size = description_.size();
+    header.description_offset = write_section(file, offset, description_.data(), description_.size());
+    header.subtime_offset = write_section(file, offset, subtimes_.data(), subtimes_.size() * sizeof(double));
+    header.walltime_offset = write_section(file, offset, walltimes_.data(), walltimes_.size() * sizeof(double));
+    header.res_offset = write_section(file, offset, res_.data(), res_.size() * sizeof(uint32_t));
+    header.profile_offset = write_section(file, offset, profiles_.data(), profiles_.size() * sizeof(uint32_t));
+    header.id_offsets_offset = write_section(file, offset, id_offsets_.data(), id_offsets_.size() * sizeof(uint64_t));
+    header.id_chars_size = id_chars_.size();
+    header.id_chars_offset = write_section(file, offset, id_chars_.data(), id_chars_.size());
+    header.profile_name_offsets_offset = write_section(file, offset, name_offsets.data(),
+                                                       name_offsets.size() * sizeof(uint64_t));
+    header.profile_name_chars_size = name_chars.size();
+    header.profile_name_chars_offset = write_section(file, offset, name_chars.data(), name_chars.size());
+    header.profile_delay_offset = write_section(file, offset, profile_delays_.data(),
+                                                profile_delays_.size() * sizeof(double));
+    header.file_size = offset;
+
+    bool ok = !ferror(file) && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) {
+        error = "cannot write '" + path + "'";
+    }
+    return ok;
+}
+
+// -------------------------
+// Mapping
+// -------------------------
+MappedWorkload::~MappedWorkload() {
+    if (data_ != nullptr) {
+        munmap(const_cast<uint8_t *>(data_), size_);
+    }
+}
+
+bool MappedWorkload::open(const std::string &path, std::string &error) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open workload file '" + path + "'";
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(BinaryWorkloadHeader)) {
+        close(fd);
+        error = "'" + path + "' is not a binary workload";
+        return false;
+    }
+    size_ = static_cast<size_t>(status.st_size);
+    void *mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        error = "cannot map '" + path + "'";
+        return false;
+    }
+    data_ = static_cast<const uint8_t *>(mapping);
+    header_ = reinterpret_cast<const BinaryWorkloadHeader *>(data_);
+
+    // Every section must be inside the file: a truncated or foreign file is rejected here,
+    // so that the accessors never have to check anything but string offsets.
+    const BinaryWorkloadHeader &h = *header_;
+    const uint64_t n = h.nb_jobs, p = h.nb_profiles;
+    auto fits = [&](uint64_t offset, uint64_t count, uint64_t item_size) {
+        return offset % 8 == 0 && offset <= size_ && count <= (size_ - offset) / item_size;
+    };
+    bool valid = memcmp(h.magic, workload_magic, sizeof(h.magic)) == 0 && h.file_size == size_
+        && n < (uint64_t(1) << 40) && p < (uint64_t(1) << 32)
+        && fits(h.description_offset, h.description_size, 1)
+        && fits(h.subtime_offset, n, sizeof(double)) && fits(h.walltime_offset, n, sizeof(double))
+        && fits(h.res_offset, n, sizeof(uint32_t)) && fits(h.profile_offset, n, sizeof(uint32_t))
+        && fits(h.id_offsets_offset, n + 1, sizeof(uint64_t)) && fits(h.id_chars_offset, h.id_chars_size, 1)
+        && fits(h.profile_name_offsets_offset, p + 1, sizeof(uint64_t))
+        && fits(h.profile_name_chars_offset, h.profile_name_chars_size, 1)
+        && fits(h.profile_delay_offset, p, sizeof(double));
+    if (!valid) {
+        error = "'" + path + "' is not a valid binary workload";
+        munmap(mapping, size_);
+        data_ = nullptr;
+        header_ = nullptr;
+        return false;
+    }
+
+    subtimes_ = reinterpret_cast<const double *>(data_ + h.subtime_offset);
+    walltimes_ = reinterpret_cast<const double *>(data_ + h.walltime_offset);
+    res_ = reinterpret_cast<const uint32_t *>(data_ + h.res_offset);
+    profiles_ = reinterpret_cast<const uint32_t *>(data_ + h.profile_offset);
+    id_offsets_ = reinterpret_cast<const uint64_t *>(data_ + h.id_offsets_offset);
+    id_chars_ = reinterpret_cast<const char *>(data_ + h.id_chars_offset);
+    profile_name_offsets_ = reinterpret_cast<const uint64_t *>(data_ + h.profile_name_offsets_offset);
+    profile_name_chars_ = reinterpret_cast<const char *>(data_ + h.profile_name_chars_offset);
+    profile_delays_ = reinterpret_cast<const double *>(data_ + h.profile_delay_offset);
+
+    // The simulation reads the columns front to back.
+    madvise(mapping, size_, MADV_SEQUENTIAL);
+    return true;
+}
+
+std::string_view MappedWorkload::description() const {
+    if (header_ == nullptr) {
+        return std::string_view();
+    }
+    return std::string_view(reinterpret_cast<const char *>(data_ + header_->description_offset),
+                            header_->description_size);
+}
+
+std::string_view MappedWorkload::job_id(size_t job) const {
+    uint64_t begin = id_offsets_[job], end = id_offsets_[job + 1];
+    if (begin > end || end > header_->id_chars_size) {
+        return std::string_view();
+    }
+    return std::string_view(id_chars_ + begin, end - begin);
+}
+
+std::string_view MappedWorkload::job_profile(size_t job) const {
+    uint32_t profile = profiles_[job];
+    if (profile >= header_->nb_profiles) {
+        return std::string_view();
+    }
+    uint64_t begin = profile_name_offsets_[profile], end = profile_name_offsets_[profile + 1];
+    if (begin > end || end > header_->profile_name_chars_size) {
+        return std::string_view();
+    }
+    return std::string_view(profile_name_chars_ + begin, end - begin);
+}
+
+double MappedWorkload::job_delay(size_t job) const {
+    uint32_t profile = profiles_[job];
+    if (profile >= header_->nb_profiles || profile_delays_[profile] < 0) {
+        return walltimes_[job];
+    }
+    return profile_delays_[profile];
+}
@@ -0,0 +1,116 @@
+// binary_workload.hpp
+//
+// Columnar binary workload, read through mmap with no parsing at all: opening a 10M-job workload
+// costs a few page faults, the columns are only paged in when the simulation touches them.
+//
+// File layout (little-endian, every section 8-byte aligned):
+//   header                BinaryWorkloadHeader below, magic "RMSEWKL1"
+//   description           description_size bytes
+//   subtime               double[nb_jobs]
+//   walltime              double[nb_jobs]    <= 0 means no walltime
+//   res                   uint32_t[nb_jobs]
+//   profile               uint32_t[nb_jobs]  index in the profile table
+//   id offsets            uint64_t[nb_jobs + 1], job i is id chars [offsets[i], offsets[i + 1])
+//   id chars
+//   profile name offsets  uint64_t[nb_profiles + 1]
+//   profile name chars
+//   profile delay         double[nb_profiles], < 0 for non-delay profiles (the job runs for its walltime)
+// Job i runs for profile_delay[profile[i]], as load_workload_json() computes it.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "workload.hpp"
+
+struct BinaryWorkloadHeader {
+    char magic[8];
+    uint32_t nb_res;
+    uint32_t reserved;
+    uint64_t nb_jobs;
+    uint64_t nb_profiles;
+    uint64_t description_offset;
+    uint64_t description_size;
+    uint64_t subtime_offset;
+    uint64_t walltime_offset;
+    uint64_t res_offset;
+    uint64_t profile_offset;
+    uint64_t id_offsets_offset;
+    uint64_t id_chars_offset;
+    uint64_t id_chars_size;
+    uint64_t profile_name_offsets_offset;
+    uint64_t profile_name_chars_offset;
+    uint64_t profile_name_chars_size;
+    uint64_t profile_delay_offset;
+    uint64_t file_size;
+};
+
+// Whether the file starts with the magic of a binary workload (JSON workloads start with '{').
+bool is_binary_workload(const std::string &path);
+
+// Accumulates a workload column by column and writes it in the binary format.
+// Profiles are referenced by name and may be defined before or after the jobs using them.
+class BinaryWorkloadWriter {
+public:
+    void set_description(const std::string &description) { description_ = description; }
+    void set_nb_res(uint32_t nb_res) { nb_res_ = nb_res; }
+    void add_job(std::string_view id, std::string_view profile, double subtime, uint32_t res, double walltime);
+    void set_profile_delay(std::string_view profile, double delay);
+
+    bool write(const std::string &path, std::string &error) const;
+
+private:
+    uint32_t profile_index(std::string_view profile);
+
+    std::string description_;
+    uint32_t nb_res_ = 0;
+    std::vector<double> subtimes_;
+    std::vector<double> walltimes_;
+    std::vector<uint32_t> res_;
+    std::vector<uint32_t> profiles_;
+    std::vector<uint64_t> id_offsets_ = {0};
+    std::string id_chars_;
+    std::vector<std::string> profile_names_;
+    std::vector<double> profile_delays_;
+    std::unordered_map<std::string, uint32_t> profile_indexes_;
+};
+
+// A binary workload mapped in memory. Accessors read the mapped columns directly.
+class MappedWorkload : public JobTable {
+public:
+    MappedWorkload() = default;
+    ~MappedWorkload();
+    MappedWorkload(const MappedWorkload &) = delete;
+    MappedWorkload &operator=(const MappedWorkload &) = delete;
+
+    bool open(const std::string &path, std::string &error);
+
+    std::string_view description() const;
+    uint32_t nb_res() const { return header_ == nullptr ? 0 : header_->nb_res; }
+
+    size_t nb_jobs() const override { return header_ == nullptr ? 0 : header_->nb_jobs; }
+    std::string_view job_id(size_t job) const override;
+    std::string_view job_profile(size_t job) const override;
+    double job_subtime(size_t job) const override { return subtimes_[job]; }
+    uint32_t job_res(size_t job) const override { return res_[job]; }
+    double job_walltime(size_t job) const override { return walltimes_[job]; }
+    double job_delay(size_t job) const override;
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+    const BinaryWorkloadHeader *header_ = nullptr;
+    const double *subtimes_ = nullptr;
+    const double *walltimes_ = nullptr;
+    const uint32_t *res_ = nullptr;
+    const uint32_t *profiles_ = nullptr;
+    const uint64_t *id_offsets_ = nullptr;
+    const char *id_chars_ = nullptr;
+    const uint64_t *profile_name_offsets_ = nullptr;
+    const char *profile_name_chars_ = nullptr;
+    const double *profile_delays_ = nullptr;
+};
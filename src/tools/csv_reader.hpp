@@ -0,0 +1,186 @@
+// csv_reader.hpp
+//
+// Zero-copy reading of Batsim's CSV outputs (jobs.csv, schedule.csv) for the native analysis tools:
+// the file is mapped with mmap, and lines and fields are split with memchr into string_views.
+// Also parses the allocated_resources column ("0-3 7 9-10").
+
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A read-only mapping of a whole file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() {
+        if (data_ != nullptr) {
+            munmap(const_cast<char *>(data_), size_);
+        }
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const std::string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat status;
+        if (fstat(fd, &status) != 0) {
+            close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(status.st_size);
+        if (size_ > 0) {
+            void *mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                close(fd);
+                return false;
+            }
+            madvise(mapping, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char *>(mapping);
+        }
+        close(fd);
+        return true;
+    }
+
+    std::string_view content() const { return std::string_view(data_ == nullptr ? "" : data_, size_); }
+
+private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Splits CSV text line by line and field by field, without copying.
+// Quoted fields ("a,b" with "" for a quote) are supported, their quotes are kept.
+class CsvReader {
+public:
+    explicit CsvReader(std::string_view text) : text_(text) {}
+
+    // Fills fields with the next line, returns false at the end of the text.
+    bool next_line(std::vector<std::string_view> &fields) {
+        fields.clear();
+        if (position_ >= text_.size()) {
+            return false;
+        }
+        const char *begin = text_.data() + position_;
+        const char *end = text_.data() + text_.size();
+        const char *line_end = static_cast<const char *>(memchr(begin, '\n', end - begin));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+
+        const char *field = begin;
+        while (true) {
+            const char *separator;
+            if (field < line_end && *field == '"') {
+                // Quoted field: may contain separators, and even line breaks.
+                const char *quote = field + 1;
+                while (true) {
+                    quote = static_cast<const char *>(memchr(quote, '"', end - quote));
+                    if (quote == nullptr || quote + 1 >= end || quote[1] != '"') {
+                        break;
+                    }
+                    quote += 2;
+                }
+                separator = (quote == nullptr) ? end : quote + 1;
+                if (separator > line_end) {
+                    line_end = static_cast<const char *>(memchr(separator, '\n', end - separator));
+                    if (line_end == nullptr) {
+                        line_end = end;
+                    }
+                }
+                const char *comma = static_cast<const char *>(memchr(separator, ',', line_end - separator));
+                separator = (comma == nullptr) ? line_end : comma;
+            } else {
+                size_t length = (field < line_end) ? static_cast<size_t>(line_end - field) : 0;
+                separator = static_cast<const char *>(memchr(field, ',', length));
+                if (separator == nullptr) {
+                    separator = line_end;
+                }
+            }
+            const char *field_end = separator;
+            if (separator == line_end && field_end > field && field_end[-1] == '\r') {
+                --field_end;
+            }
+            fields.emplace_back(field, field_end - field);
+            if (separator == line_end) {
+                break;
+            }
+            field = separator + 1;
+        }
+        position_ = (line_end - text_.data()) + 1;
+        return true;
+    }
+
+private:
+    std::string_view text_;
+    size_t position_ = 0;
+};
+
+// Column index of name in header, or -1.
+inline int column(const std::vector<std::string_view> &header, const char *name) {
+    for (size_t i = 0; i < header.size(); ++i) {
+        if (header[i] == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// Parses a numeric field. Empty fields (e.g. rejected jobs) are missing values, as pandas makes them NaN.
+inline bool parse_number(const std::vector<std::string_view> &fields, int index, double &value) {
+    if (index < 0 || static_cast<size_t>(index) >= fields.size() || fields[index].empty()) {
+        return false;
+    }
+    char buffer[64];
+    size_t length = std::min(fields[index].size(), sizeof(buffer) - 1);
+    memcpy(buffer, fields[index].data(), length);
+    buffer[length] = '\0';
+    char *end = nullptr;
+    value = strtod(buffer, &end);
+    return end != buffer && !std::isnan(value);
+}
+
+// Calls f(first, last) for every interval of an allocation, hosts being separated by spaces or commas.
+template <typename F>
+inline size_t for_each_interval(std::string_view allocation, F f) {
+    if (allocation.size() >= 2 && allocation.front() == '"' && allocation.back() == '"') {
+        allocation = allocation.substr(1, allocation.size() - 2);
+    }
+    size_t nb_intervals = 0;
+    size_t position = 0;
+    while (position < allocation.size()) {
+        size_t token_end = allocation.find_first_of(" ,", position);
+        if (token_end == std::string_view::npos) {
+            token_end = allocation.size();
+        }
+        std::string_view token = allocation.substr(position, token_end - position);
+        position = token_end + 1;
+        if (token.empty()) {
+            continue;
+        }
+        uint32_t first = 0, last = 0;
+        auto parsed = std::from_chars(token.data(), token.data() + token.size(), first);
+        if (parsed.ptr < token.data() + token.size() && *parsed.ptr == '-') {
+            std::from_chars(parsed.ptr + 1, token.data() + token.size(), last);
+        } else {
+            last = first;
+        }
+        f(first, std::max(first, last));
+        nb_intervals++;
+    }
+    return nb_intervals;
+}
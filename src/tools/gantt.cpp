@@ -0,0 +1,465 @@
+// gantt.cpp
+//
+// Gantt chart of a Batsim jobs.csv, rendered at a fixed resolution whatever the size of the schedule.
+// Instead of drawing one rectangle per job, every allocation is accumulated into a time x host grid
+// of pixels: each pixel holds the fraction of its host-seconds that were busy, and the fraction that
+// was used by non-contiguous allocations. Memory is bounded by the image size, and each job costs
+// a constant number of updates (a 2D difference array), so million-job schedules render in seconds.
+//
+// Pixels are shaded from white (idle) to blue (busy); the busy part of non-contiguous allocations
+// is drawn in red instead, so fragmentation shows up where it happens.
+// The output format follows the extension: .svg (with axes, rows run-length encoded) or .png
+// (raw RGB raster, stored without compression so that no zlib is needed).
+//
+// Usage: gantt <jobs.csv> <output.svg|output.png> [--width px] [--height px] [--hosts n]
+//                                                   [--start t] [--end t]
+//   --width, --height  size of the plot area in pixels (default 1600 x 800)
+//   --hosts n          number of hosts (default: largest allocated host + 1)
+//   --start, --end     time window (default: 0 to the last finish time)
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "csv_reader.hpp"
+
+struct GanttOptions {
+    std::string input;
+    std::string output;
+    uint32_t width = 1600;
+    uint32_t height = 800;
+    uint32_t nb_hosts = 0;
+    double start = 0;
+    double end = -1;
+};
+
+// A job of jobs.csv, with its allocation still as text ("0-3 7 9-10").
+struct ScheduledJob {
+    double starting_time;
+    double finish_time;
+    std::string_view allocation;
+};
+
+// Reads every job that ran, calling f(job). Returns false if the columns are missing.
+template <typename F>
+static bool for_each_job(std::string_view text, F f) {
+    CsvReader reader(text);
+    std::vector<std::string_view> header, fields;
+    if (!reader.next_line(header)) {
+        return false;
+    }
+    int start_column = column(header, "starting_time");
+    int finish_column = column(header, "finish_time");
+    int allocation_column = column(header, "allocated_resources");
+    if (start_column < 0 || finish_column < 0 || allocation_column < 0) {
+        return false;
+    }
+    while (reader.next_line(fields)) {
+        ScheduledJob job;
+        if (static_cast<size_t>(allocation_column) >= fields.size() || fields[allocation_column].empty()
+            || !parse_number(fields, start_column, job.starting_time)
+            || !parse_number(fields, finish_column, job.finish_time)) {
+            continue; // rejected, or never started
+        }
+        job.allocation = fields[allocation_column];
+        f(job);
+    }
+    return true;
+}
+
+// Coverage of a width x height pixel grid by weighted rectangles with fractional bounds.
+// Rectangles are added to a 2D difference array in O(1): the overlap of a rectangle with a pixel
+// is the product of its overlaps along x and y, each being partial at both ends and 1 in between,
+// so a rectangle splits into at most 3 x 3 blocks of constant coverage.
+class CoverageGrid {
+public:
+    CoverageGrid(uint32_t width, uint32_t height)
+        : width_(width), height_(height), cells_(static_cast<size_t>(width + 1) * (height + 1), 0.0) {}
+
+    // Adds the rectangle [x0, x1) x [y0, y1), in pixel units, clipped to the grid.
+    void add(double x0, double x1, double y0, double y1) {
+        x0 = std::max(x0, 0.0);
+        y0 = std::max(y0, 0.0);
+        x1 = std::min(x1, static_cast<double>(width_));
+        y1 = std::min(y1, static_cast<double>(height_));
+        if (x1 <= x0 || y1 <= y0) {
+            return;
+        }
+        Segment xs[3], ys[3];
+        int nx = split(x0, x1, width_, xs);
+        int ny = split(y0, y1, height_, ys);
+        for (int i = 0; i < nx; ++i) {
+            for (int j = 0; j < ny; ++j) {
+                add_block(xs[i].first, xs[i].last, ys[j].first, ys[j].last, xs[i].weight * ys[j].weight);
+            }
+        }
+    }
+
+    // Turns the differences into per-pixel coverage. Call once, after the last add().
+    void resolve() {
+        for (uint32_t y = 0; y <= height_; ++y) {
+            for (uint32_t x = 1; x <= width_; ++x) {
+                cells_[index(x, y)] += cells_[index(x - 1, y)];
+            }
+        }
+        for (uint32_t y = 1; y <= height_; ++y) {
+            for (uint32_t x = 0; x <= width_; ++x) {
+                cells_[index(x, y)] += cells_[index(x, y - 1)];
+            }
+        }
+    }
+
+    double at(uint32_t x, uint32_t y) const { return cells_[index(x, y)]; }
+
+private:
+    struct Segment {
+        uint32_t first;
+        uint32_t last;
+        double weight;
+    };
+
+    size_t index(uint32_t x, uint32_t y) const { return static_cast<size_t>(y) * (width_ + 1) + x; }
+
+    static int split(double low, double high, uint32_t size, Segment segments[3]) {
+        uint32_t first = std::min(static_cast<uint32_t>(low), size - 1);
+        uint32_t last = std::min(static_cast<uint32_t>(std::ceil(high)) - 1, size - 1);
+        if (first == last) {
+            segments[0] = {first, first, high - low};
+            return 1;
+        }
+        int n = 0;
+        segments[n++] = {first, first, (first + 1) - low};
+        if (last > first + 1) {
+            segments[n++] = {first + 1, last - 1, 1.0};
+        }
+        segments[n++] = {last, last, high - last};
+        return n;
+    }
+
+    void add_block(uint32_t x0, uint32_t x1, uint32_t y0, uint32_t y1, double weight) {
+        cells_[index(x0, y0)] += weight;
+        cells_[index(x1 + 1, y0)] -= weight;
+        cells_[index(x0, y1 + 1)] -= weight;
+        cells_[index(x1 + 1, y1 + 1)] += weight;
+    }
+
+    uint32_t width_;
+    uint32_t height_;
+    std::vector<double> cells_;
+};
+
+struct Rgb {
+    uint8_t r, g, b;
+};
+
+const Rgb IDLE_COLOR = {255, 255, 255};
+const Rgb BUSY_COLOR = {70, 130, 180};
+const Rgb NON_CONTIGUOUS_COLOR = {214, 39, 40};
+
+static uint8_t blend(uint8_t a, uint8_t b, double t) {
+    return static_cast<uint8_t>(std::lround(a + (b - a) * t));
+}
+
+// busy and non_contiguous are coverage fractions in [0, 1], non_contiguous <= busy.
+static Rgb shade(double busy, double non_contiguous) {
+    double red_share = busy > 0 ? std::min(std::max(non_contiguous / busy, 0.0), 1.0) : 0.0;
+    busy = std::min(std::max(busy, 0.0), 1.0);
+    Rgb used = {blend(BUSY_COLOR.r, NON_CONTIGUOUS_COLOR.r, red_share),
+                blend(BUSY_COLOR.g, NON_CONTIGUOUS_COLOR.g, red_share),
+                blend(BUSY_COLOR.b, NON_CONTIGUOUS_COLOR.b, red_share)};
+    return {blend(IDLE_COLOR.r, used.r, busy), blend(IDLE_COLOR.g, used.g, busy), blend(IDLE_COLOR.b, used.b, busy)};
+}
+
+// -------------------------
+// PNG output
+// -------------------------
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t size) {
+    static uint32_t table[256];
+    static bool table_ready = false;
+    if (!table_ready) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        table_ready = true;
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void put_u32(std::vector<uint8_t> &out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static void write_chunk(FILE *file, const char type[4], const std::vector<uint8_t> &data) {
+    std::vector<uint8_t> chunk;
+    put_u32(chunk, static_cast<uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    uint32_t crc = crc32_update(0, chunk.data() + 4, chunk.size() - 4);
+    put_u32(chunk, crc);
+    fwrite(chunk.data(), 1, chunk.size(), file);
+}
+
+// rows holds height rows of 1 filter byte + 3 * width bytes, top row first.
+static bool write_png(const std::string &path, uint32_t width, uint32_t height, const std::vector<uint8_t> &rows) {
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite(signature, 1, sizeof(signature), file);
+
+    std::vector<uint8_t> header;
+    put_u32(header, width);
+    put_u32(header, height);
+    header.insert(header.end(), {8, 2, 0, 0, 0}); // 8-bit RGB, deflate, no filter method, no interlace
+    write_chunk(file, "IHDR", header);
+
+    // zlib stream made of stored (uncompressed) deflate blocks of at most 65535 bytes.
+    std::vector<uint8_t> zlib = {0x78, 0x01};
+    uint32_t adler_a = 1, adler_b = 0;
+    for (size_t offset = 0; offset < rows.size() || offset == 0;) {
+        size_t size = std::min<size_t>(65535, rows.size() - offset);
+        bool last = offset + size == rows.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(static_cast<uint8_t>(size));
+        zlib.push_back(static_cast<uint8_t>(size >> 8));
+        zlib.push_back(static_cast<uint8_t>(~size));
+        zlib.push_back(static_cast<uint8_t>(~size >> 8));
+        zlib.insert(zlib.end(), rows.begin() + offset, rows.begin() + offset + size);
+        for (size_t i = offset; i < offset + size; ++i) {
+            adler_a = (adler_a + rows[i]) % 65521;
+            adler_b = (adler_b + adler_a) % 65521;
+        }
+        offset += size;
+        if (last) {
+            break;
+        }
+    }
+    put_u32(zlib, (adler_b << 16) | adler_a);
+    write_chunk(file, "IDAT", zlib);
+    write_chunk(file, "IEND", {});
+    bool ok = !ferror(file);
+    return (fclose(file) == 0) && ok;
+}
+
+// -------------------------
+// SVG output
+// -------------------------
+const uint32_t SVG_MARGIN_LEFT = 70;
+const uint32_t SVG_MARGIN_RIGHT = 20;
+const uint32_t SVG_MARGIN_TOP = 30;
+const uint32_t SVG_MARGIN_BOTTOM = 50;
+
+// Colors are quantized before the run-length encoding of each row, so that uniform areas become
+// a single rectangle: the file size follows the visual complexity, not the number of jobs.
+static Rgb quantized_shade(double busy, double non_contiguous) {
+    const double levels = 16;
+    double quantized_busy = std::round(std::min(std::max(busy, 0.0), 1.0) * levels) / levels;
+    double share = busy > 0 ? std::round(std::min(std::max(non_contiguous / busy, 0.0), 1.0) * 4) / 4 : 0.0;
+    return shade(quantized_busy, quantized_busy * share);
+}
+
+// Round tick step (1, 2 or 5 times a power of ten) giving about target ticks over range.
+static double tick_step(double range, int target) {
+    double raw = range / target;
+    double magnitude = std::pow(10.0, std::floor(std::log10(raw)));
+    for (double factor : {1.0, 2.0, 5.0}) {
+        if (factor * magnitude >= raw) {
+            return factor * magnitude;
+        }
+    }
+    return 10 * magnitude;
+}
+
+static bool write_svg(const std::string &path, const GanttOptions &options, const CoverageGrid &busy,
+                      const CoverageGrid &non_contiguous, uint64_t nb_jobs) {
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    setvbuf(file, nullptr, _IOFBF, 1 << 20);
+    uint32_t width = options.width, height = options.height;
+    fprintf(file, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%u\" height=\"%u\" font-family=\"sans-serif\" font-size=\"12\">\n",
+            width + SVG_MARGIN_LEFT + SVG_MARGIN_RIGHT, height + SVG_MARGIN_TOP + SVG_MARGIN_BOTTOM);
+    fprintf(file, "<rect width=\"100%%\" height=\"100%%\" fill=\"white\"/>\n");
+    fprintf(file, "<text x=\"%u\" y=\"20\">%" PRIu64 " jobs on %u hosts, %g s to %g s</text>\n", SVG_MARGIN_LEFT,
+            nb_jobs, options.nb_hosts, options.start, options.end);
+    fprintf(file, "<g transform=\"translate(%u,%u)\" shape-rendering=\"crispEdges\">\n", SVG_MARGIN_LEFT, SVG_MARGIN_TOP);
+
+    for (uint32_t y = 0; y < height; ++y) {
+        uint32_t row = height - 1 - y; // host 0 at the bottom
+        uint32_t x = 0;
+        while (x < width) {
+            Rgb color = quantized_shade(busy.at(x, row), non_contiguous.at(x, row));
+            uint32_t run_end = x + 1;
+            while (run_end < width) {
+                Rgb next = quantized_shade(busy.at(run_end, row), non_contiguous.at(run_end, row));
+                if (next.r != color.r || next.g != color.g || next.b != color.b) {
+                    break;
+                }
+                run_end++;
+            }
+            if (color.r != IDLE_COLOR.r || color.g != IDLE_COLOR.g || color.b != IDLE_COLOR.b) {
+                fprintf(file, "<rect x=\"%u\" y=\"%u\" width=\"%u\" height=\"1\" fill=\"#%02x%02x%02x\"/>\n",
+                        x, y, run_end - x, color.r, color.g, color.b);
+            }
+            x = run_end;
+        }
+    }
+
+    // Axes: time along x, hosts along y.
+    fprintf(file, "<rect width=\"%u\" height=\"%u\" fill=\"none\" stroke=\"black\"/>\n", width, height);
+    double duration = options.end - options.start;
+    double step = tick_step(duration, 10);
+    for (double t = std::ceil(options.start / step) * step; t <= options.end; t += step) {
+        double x = (t - options.start) / duration * width;
+        fprintf(file, "<line x1=\"%.1f\" y1=\"%u\" x2=\"%.1f\" y2=\"%u\" stroke=\"black\"/>\n", x, height, x, height + 5);
+        fprintf(file, "<text x=\"%.1f\" y=\"%u\" text-anchor=\"middle\">%g</text>\n", x, height + 18, t);
+    }
+    fprintf(file, "<text x=\"%u\" y=\"%u\" text-anchor=\"middle\">time (s)</text>\n", width / 2, height + 38);
+    double host_step = std::max(1.0, tick_step(options.nb_hosts, 8));
+    for (double h = 0; h <= options.nb_hosts; h += host_step) {
+        double y = height - h / options.nb_hosts * height;
+        fprintf(file, "<line x1=\"-5\" y1=\"%.1f\" x2=\"0\" y2=\"%.1f\" stroke=\"black\"/>\n", y, y);
+        fprintf(file, "<text x=\"-8\" y=\"%.1f\" text-anchor=\"end\" dominant-baseline=\"middle\">%g</text>\n", y, h);
+    }
+    fprintf(file, "<text transform=\"translate(-55,%u) rotate(-90)\" text-anchor=\"middle\">hosts</text>\n", height / 2);
+    fprintf(file, "</g>\n");
+    fprintf(file, "<text x=\"%u\" y=\"20\" text-anchor=\"end\" fill=\"#%02x%02x%02x\">non-contiguous allocations</text>\n",
+            width + SVG_MARGIN_LEFT, NON_CONTIGUOUS_COLOR.r, NON_CONTIGUOUS_COLOR.g, NON_CONTIGUOUS_COLOR.b);
+    fprintf(file, "</svg>\n");
+    bool ok = !ferror(file);
+    return (fclose(file) == 0) && ok;
+}
+
+static bool ends_with(const std::string &text, const std::string &suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static bool parse_options(int argc, char **argv, GanttOptions &options) {
+    if (argc < 3) {
+        return false;
+    }
+    options.input = argv[1];
+    options.output = argv[2];
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--width") {
+            options.width = static_cast<uint32_t>(std::max(1ll, std::stoll(value)));
+        } else if (arg == "--height") {
+            options.height = static_cast<uint32_t>(std::max(1ll, std::stoll(value)));
+        } else if (arg == "--hosts") {
+            options.nb_hosts = static_cast<uint32_t>(std::stoul(value));
+        } else if (arg == "--start") {
+            options.start = std::stod(value);
+        } else if (arg == "--end") {
+            options.end = std::stod(value);
+        } else {
+            printf("Unknown option '%s'\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    GanttOptions options;
+    if (!parse_options(argc, argv, options) || !(ends_with(options.output, ".svg") || ends_with(options.output, ".png"))) {
+        printf("Usage: %s <jobs.csv> <output.svg|output.png> [--width px] [--height px] [--hosts n] "
+               "[--start t] [--end t]\n", argv[0]);
+        return 1;
+    }
+    MappedFile input;
+    if (!input.open(options.input)) {
+        printf("Error: cannot open '%s'\n", options.input.c_str());
+        return 1;
+    }
+
+    // First pass, only when the extent of the schedule is not given.
+    if (options.nb_hosts == 0 || options.end < 0) {
+        double last_finish = 0;
+        uint32_t last_host = 0;
+        for_each_job(input.content(), [&](const ScheduledJob &job) {
+            last_finish = std::max(last_finish, job.finish_time);
+            for_each_interval(job.allocation, [&](uint32_t, uint32_t last) { last_host = std::max(last_host, last); });
+        });
+        if (options.nb_hosts == 0) {
+            options.nb_hosts = last_host + 1;
+        }
+        if (options.end < 0) {
+            options.end = last_finish;
+        }
+    }
+    if (options.end <= options.start) {
+        options.end = options.start + 1;
+    }
+
+    CoverageGrid busy(options.width, options.height);
+    CoverageGrid non_contiguous(options.width, options.height);
+    const double x_scale = options.width / (options.end - options.start);
+    const double y_scale = static_cast<double>(options.height) / options.nb_hosts;
+    uint64_t nb_jobs = 0;
+    bool ok = for_each_job(input.content(), [&](const ScheduledJob &job) {
+        double x0 = (job.starting_time - options.start) * x_scale;
+        double x1 = (job.finish_time - options.start) * x_scale;
+        nb_jobs++;
+        size_t nb_intervals = for_each_interval(job.allocation, [&](uint32_t first, uint32_t last) {
+            busy.add(x0, x1, first * y_scale, (last + 1.0) * y_scale);
+        });
+        if (nb_intervals > 1) {
+            for_each_interval(job.allocation, [&](uint32_t first, uint32_t last) {
+                non_contiguous.add(x0, x1, first * y_scale, (last + 1.0) * y_scale);
+            });
+        }
+    });
+    if (!ok) {
+        printf("Error: '%s' has no starting_time, finish_time and allocated_resources columns\n", options.input.c_str());
+        return 1;
+    }
+    busy.resolve();
+    non_contiguous.resolve();
+
+    bool written;
+    if (ends_with(options.output, ".png")) {
+        std::vector<uint8_t> rows;
+        rows.reserve(static_cast<size_t>(options.height) * (1 + 3 * options.width));
+        for (uint32_t y = 0; y < options.height; ++y) {
+            uint32_t row = options.height - 1 - y; // host 0 at the bottom
+            rows.push_back(0); // no filter
+            for (uint32_t x = 0; x < options.width; ++x) {
+                Rgb color = shade(busy.at(x, row), non_contiguous.at(x, row));
+                rows.insert(rows.end(), {color.r, color.g, color.b});
+            }
+        }
+        written = write_png(options.output, options.width, options.height, rows);
+    } else {
+        written = write_svg(options.output, options, busy, non_contiguous, nb_jobs);
+    }
+    if (!written) {
+        printf("Error: cannot write '%s'\n", options.output.c_str());
+        return 1;
+    }
+    printf("Rendered %" PRIu64 " jobs on %u hosts into %s (%u x %u)\n", nb_jobs, options.nb_hosts,
+           options.output.c_str(), options.width, options.height);
+    return 0;
+}
@@ -0,0 +1,124 @@
+// generate_jobs.cpp
+//
+// Native replacement for scripts/generate_jobs.py.
+// The workload is streamed to disk as it is generated, so memory does not depend on the number of jobs:
+// the jobs are written first, then the generator is rewound (same seed) to write the delay profiles,
+// which only need the walltimes. The output is byte-for-byte what json.dump(job_set, f, indent=2) writes.
+//
+// Usage: generate_jobs <num_jobs> <max_hosts> <filename> [--seed s] [--output-dir assets/generated]
+//                      [--res dist] [--walltime dist] [--subtime dist]
+// Distributions are described in workload.hpp, e.g. --walltime loguniform:60:86400 --subtime poisson:30.
+// The defaults are those of generate_jobs.py.
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+#include "json_output.hpp"
+#include "workload.hpp"
+
+static void print_usage(const char *program) {
+    printf("Usage: %s <num_jobs> <max_hosts> <filename> [--seed s] [--output-dir assets/generated]\n", program);
+    printf("          [--res dist] [--walltime dist] [--subtime dist]\n");
+    printf("Distributions: uniform:a:b, loguniform:a:b, lublin[:max] (res), poisson:mean (subtime)\n");
+    printf("Example: %s 1000 6 jobs_1000.json\n", program);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    uint64_t num_jobs = std::strtoull(argv[1], nullptr, 10);
+    uint32_t max_hosts = static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10));
+    std::string filename = argv[3];
+    uint64_t seed = 1;
+    std::string output_dir = "assets/generated";
+    GeneratorSettings settings = default_generator_settings(max_hosts);
+
+    for (int i = 4; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        std::string error;
+        bool ok = true;
+        if (arg == "--seed") {
+            seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--output-dir") {
+            output_dir = value;
+        } else if (arg == "--res") {
+            ok = parse_distribution(value, settings.res, error);
+        } else if (arg == "--walltime") {
+            ok = parse_distribution(value, settings.walltime, error);
+        } else if (arg == "--subtime") {
+            ok = parse_distribution(value, settings.subtime, error);
+        } else {
+            error = "unknown option '" + arg + "'";
+            ok = false;
+        }
+        if (ok && ((arg == "--res" && settings.res.kind == Distribution::POISSON)
+                   || (arg == "--walltime" && (settings.walltime.kind == Distribution::POISSON
+                                               || settings.walltime.kind == Distribution::LUBLIN))
+                   || (arg == "--subtime" && settings.subtime.kind == Distribution::LUBLIN))) {
+            error = "distribution '" + value + "' cannot be used for " + arg.substr(2);
+            ok = false;
+        }
+        if (!ok) {
+            printf("Error: %s\n", error.c_str());
+            return 1;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(output_dir, ec);
+    std::string output_path = output_dir + "/" + filename;
+    FILE *file = fopen(output_path.c_str(), "wb");
+    if (file == nullptr) {
+        printf("Error: cannot open '%s' for writing\n", output_path.c_str());
+        return 1;
+    }
+
+    bool ok = true;
+    {
+        JsonOutput out(file);
+        out.text("{\n  \"description\": \"").text(generated_workload_description(num_jobs, max_hosts))
+           .text("\",\n  \"nb_res\": ").number(static_cast<double>(max_hosts) * 2)
+           .text(",\n  \"jobs\": [");
+
+        WorkloadJob job;
+        JobGenerator jobs(settings, seed);
+        for (uint64_t i = 0; i < num_jobs; ++i) {
+            jobs.next(job);
+            out.text(i == 0 ? "\n    {\n      \"id\": \"" : ",\n    {\n      \"id\": \"").text(job.id)
+               .text("\",\n      \"profile\": \"").text(job.profile)
+               .text("\",\n      \"res\": ").number(job.res)
+               .text(",\n      \"walltime\": ").number(job.walltime)
+               .text(",\n      \"subtime\": ").number(job.subtime)
+               .text("\n    }");
+        }
+        out.text(num_jobs == 0 ? "],\n  \"profiles\": {" : "\n  ],\n  \"profiles\": {");
+
+        // Same seed, same jobs: the profiles are written without keeping anything from the first pass.
+        JobGenerator profiles(settings, seed);
+        for (uint64_t i = 0; i < num_jobs; ++i) {
+            profiles.next(job);
+            out.text(i == 0 ? "\n    \"" : ",\n    \"").text(job.profile)
+               .text("\": {\n      \"delay\": ").number(job.delay)
+               .text(",\n      \"type\": \"delay\"\n    }");
+        }
+        out.text(num_jobs == 0 ? "}\n}" : "\n  }\n}");
+        ok = out.flush();
+    }
+    if (fclose(file) != 0 || !ok) {
+        printf("Error: cannot write '%s'\n", output_path.c_str());
+        return 1;
+    }
+
+    printf("Generated %" PRIu64 " jobs with max %u hosts and saved to %s\n", num_jobs, max_hosts, output_path.c_str());
+    return 0;
+}
@@ -0,0 +1,187 @@
+// generate_platform.cpp
+//
+// Native replacement for scripts/generate_machines.py, for platforms of up to hundreds of thousands of hosts.
+// Hosts are always named node_0 .. node_<n-1>, plus the master_host Batsim talks to the scheduler from.
+// Topologies:
+//   flat     one Full zone listing every host, byte-for-byte what generate_machines.py writes
+//            (the file grows with the number of hosts, and SimGrid's Full routing with it)
+//   cluster  one SimGrid <cluster> tag for all the compute hosts (a single line whatever their number),
+//            linked to the master zone through a backbone link
+//   zones    the hosts split into --zones clusters of consecutive hosts, every pair of clusters and
+//            every cluster and the master linked through the backbone
+//
+// Usage: generate_platform <num_hosts> [--topology flat|cluster|zones] [--zones k]
+//                          [--output-dir assets/generated/machines] [--output file]
+//                          [--speed 10Gf] [--master-speed 100Mf] [--bw 10Gbps] [--lat 10us]
+//                          [--backbone-bw 100Gbps] [--backbone-lat 10us]
+// The default output is <output_dir>/machines_<n>.xml (flat), machines_<n>_cluster.xml or machines_<n>_zones<k>.xml.
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+struct PlatformOptions {
+    uint64_t num_hosts = 0;
+    std::string topology = "flat";
+    uint64_t nb_zones = 4;
+    std::string output_dir = "assets/generated/machines";
+    std::string output;
+    std::string speed = "10Gf";
+    std::string master_speed = "100Mf";
+    std::string bandwidth = "10Gbps";
+    std::string latency = "10us";
+    std::string backbone_bandwidth = "100Gbps";
+    std::string backbone_latency = "10us";
+};
+
+static void print_usage(const char *program) {
+    printf("Usage: %s <num_hosts> [--topology flat|cluster|zones] [--zones k]\n", program);
+    printf("          [--output-dir assets/generated/machines] [--output file]\n");
+    printf("          [--speed 10Gf] [--master-speed 100Mf] [--bw 10Gbps] [--lat 10us]\n");
+    printf("          [--backbone-bw 100Gbps] [--backbone-lat 10us]\n");
+    printf("Example: %s 100000 --topology zones --zones 16\n", program);
+}
+
+static void write_header(FILE *file) {
+    fprintf(file, "<?xml version='1.0'?>\n"
+                  "<!DOCTYPE platform SYSTEM \"https://simgrid.org/simgrid.dtd\">\n"
+                  "<platform version=\"4.1\">\n\n");
+}
+
+// Same content as generate_machines.py, which writes no newline after </platform>.
+static void write_flat(FILE *file, const PlatformOptions &options) {
+    write_header(file);
+    fprintf(file, "<zone id=\"machines_%" PRIu64 "\" routing=\"Full\">\n", options.num_hosts);
+    for (uint64_t i = 0; i < options.num_hosts; ++i) {
+        fprintf(file, "    <host id=\"node_%" PRIu64 "\" speed=\"%s\"/>\n", i, options.speed.c_str());
+    }
+    fprintf(file, "    <host id=\"master_host\" speed=\"%s\"/>\n", options.master_speed.c_str());
+    fprintf(file, "</zone>\n</platform>");
+}
+
+// A SimGrid cluster names its hosts <prefix><radical><suffix> and its router <prefix><id>_router<suffix>.
+static std::string cluster_router(uint64_t zone) {
+    return "node_cluster_" + std::to_string(zone) + "_router";
+}
+
+static void write_clusters(FILE *file, const PlatformOptions &options, uint64_t nb_clusters) {
+    write_header(file);
+    fprintf(file, "<zone id=\"machines_%" PRIu64 "\" routing=\"Full\">\n", options.num_hosts);
+    uint64_t first = 0;
+    for (uint64_t zone = 0; zone < nb_clusters; ++zone) {
+        // Consecutive hosts, the first num_hosts % nb_clusters clusters taking one more.
+        uint64_t size = options.num_hosts / nb_clusters + (zone < options.num_hosts % nb_clusters ? 1 : 0);
+        fprintf(file, "    <cluster id=\"cluster_%" PRIu64 "\" prefix=\"node_\" suffix=\"\" radical=\"%" PRIu64 "-%" PRIu64
+                      "\" speed=\"%s\" bw=\"%s\" lat=\"%s\" bb_bw=\"%s\" bb_lat=\"%s\"/>\n",
+                zone, first, first + size - 1, options.speed.c_str(), options.bandwidth.c_str(), options.latency.c_str(),
+                options.backbone_bandwidth.c_str(), options.backbone_latency.c_str());
+        first += size;
+    }
+    fprintf(file, "    <zone id=\"master\" routing=\"Full\">\n");
+    fprintf(file, "        <host id=\"master_host\" speed=\"%s\"/>\n", options.master_speed.c_str());
+    fprintf(file, "    </zone>\n");
+    fprintf(file, "    <link id=\"backbone\" bandwidth=\"%s\" latency=\"%s\"/>\n", options.backbone_bandwidth.c_str(),
+            options.backbone_latency.c_str());
+    // Full routing needs a route between every pair of zones; routes are symmetrical by default.
+    for (uint64_t zone = 0; zone < nb_clusters; ++zone) {
+        for (uint64_t other = zone + 1; other < nb_clusters; ++other) {
+            fprintf(file, "    <zoneRoute src=\"cluster_%" PRIu64 "\" dst=\"cluster_%" PRIu64 "\" gw_src=\"%s\" gw_dst=\"%s\">\n"
+                          "        <link_ctn id=\"backbone\"/>\n"
+                          "    </zoneRoute>\n",
+                    zone, other, cluster_router(zone).c_str(), cluster_router(other).c_str());
+        }
+        fprintf(file, "    <zoneRoute src=\"cluster_%" PRIu64 "\" dst=\"master\" gw_src=\"%s\" gw_dst=\"master_host\">\n"
+                      "        <link_ctn id=\"backbone\"/>\n"
+                      "    </zoneRoute>\n",
+                zone, cluster_router(zone).c_str());
+    }
+    fprintf(file, "</zone>\n</platform>\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    PlatformOptions options;
+    options.num_hosts = std::strtoull(argv[1], nullptr, 10);
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--topology") {
+            options.topology = value;
+        } else if (arg == "--zones") {
+            options.nb_zones = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--output-dir") {
+            options.output_dir = value;
+        } else if (arg == "--output") {
+            options.output = value;
+        } else if (arg == "--speed") {
+            options.speed = value;
+        } else if (arg == "--master-speed") {
+            options.master_speed = value;
+        } else if (arg == "--bw") {
+            options.bandwidth = value;
+        } else if (arg == "--lat") {
+            options.latency = value;
+        } else if (arg == "--backbone-bw") {
+            options.backbone_bandwidth = value;
+        } else if (arg == "--backbone-lat") {
+            options.backbone_latency = value;
+        } else {
+            printf("Error: unknown option '%s'\n", arg.c_str());
+            return 1;
+        }
+    }
+    if (options.num_hosts == 0) {
+        printf("Error: the number of hosts must be positive\n");
+        return 1;
+    }
+    if (options.topology != "flat" && options.topology != "cluster" && options.topology != "zones") {
+        printf("Error: unknown topology '%s' (expected flat, cluster or zones)\n", options.topology.c_str());
+        return 1;
+    }
+    if (options.topology == "zones" && (options.nb_zones == 0 || options.nb_zones > options.num_hosts)) {
+        printf("Error: --zones must be between 1 and the number of hosts\n");
+        return 1;
+    }
+
+    std::string output_path = options.output;
+    if (output_path.empty()) {
+        std::string name = "machines_" + std::to_string(options.num_hosts);
+        if (options.topology == "cluster") {
+            name += "_cluster";
+        } else if (options.topology == "zones") {
+            name += "_zones" + std::to_string(options.nb_zones);
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(options.output_dir, ec);
+        output_path = options.output_dir + "/" + name + ".xml";
+    }
+    FILE *file = fopen(output_path.c_str(), "wb");
+    if (file == nullptr) {
+        printf("Error: cannot open '%s' for writing\n", output_path.c_str());
+        return 1;
+    }
+    setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+    if (options.topology == "flat") {
+        write_flat(file, options);
+    } else {
+        write_clusters(file, options, options.topology == "cluster" ? 1 : options.nb_zones);
+    }
+    bool ok = !ferror(file);
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) {
+        printf("Error: cannot write '%s'\n", output_path.c_str());
+        return 1;
+    }
+    printf("Generated machine file: %s\n", output_path.c_str());
+    return 0;
+}
@@ -0,0 +1,89 @@
+// json_output.hpp
+//
+// Buffered writer for the native tools that stream Batsim workloads to disk
+// (generate_jobs, swf2json) in the layout of Python's json.dump(..., indent=2).
+
+#pragma once
+
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Buffered writer of the few JSON tokens a workload is made of.
+class JsonOutput {
+public:
+    explicit JsonOutput(FILE *file) : file_(file) {
+        buffer_.reserve(capacity);
+    }
+
+    ~JsonOutput() {
+        flush();
+    }
+
+    JsonOutput &text(const char *value) {
+        buffer_ += value;
+        return maybe_flush();
+    }
+
+    JsonOutput &text(const std::string &value) {
+        buffer_ += value;
+        return maybe_flush();
+    }
+
+    // Numbers are integral in generated workloads, as Python writes them.
+    JsonOutput &number(double value) {
+        char digits[32];
+        int length = snprintf(digits, sizeof(digits), "%" PRId64, static_cast<int64_t>(value));
+        buffer_.append(digits, length);
+        return maybe_flush();
+    }
+
+    // A JSON string, escaped as json.dump does for ASCII text.
+    JsonOutput &string(const std::string &value) {
+        buffer_ += '"';
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                buffer_ += '\\';
+                buffer_ += c;
+            } else if (c == '\n') {
+                buffer_ += "\\n";
+            } else if (c == '\t') {
+                buffer_ += "\\t";
+            } else if (c == '\r') {
+                buffer_ += "\\r";
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                buffer_ += escaped;
+            } else {
+                buffer_ += c;
+            }
+        }
+        buffer_ += '"';
+        return maybe_flush();
+    }
+
+    // Returns false if anything written so far could not be written to the file.
+    bool flush() {
+        if (fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()) {
+            failed_ = true;
+        }
+        buffer_.clear();
+        return !failed_;
+    }
+
+private:
+    static const size_t capacity = 1 << 20;
+
+    JsonOutput &maybe_flush() {
+        if (buffer_.size() >= capacity - 256) {
+            flush();
+        }
+        return *this;
+    }
+
+    FILE *file_;
+    std::string buffer_;
+    bool failed_ = false;
+};
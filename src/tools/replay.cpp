@@ -0,0 +1,161 @@
+// replay.cpp
+//
+// Replays a message trace recorded by a scheduler (init data key "trace_file", see msg_trace.hpp)
+// into any scheduler library, without Batsim. Every decision buffer is compared bit-for-bit with
+// the recorded one, and the latency of every call is measured, which turns a recorded trace into
+// a deterministic benchmark and regression test.
+//
+// Usage: replay <trace_file> <lib.so> [--repeat n] [--no-check] [--init-data json]
+//   --repeat n          replays the trace n times (re-initializing the library every time)
+//   --no-check          only measures, e.g. to compare two versions of a scheduler on the same trace
+//   --init-data json    init data given to the library instead of the recorded one
+// Exits with 1 if any decision differs from the recorded one.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "../batsim_edc.h"
+#include "../log_histogram.hpp"
+#include "../msg_trace.hpp"
+#include "simulator.hpp"
+
+// The recorded init data, without what would make the replay overwrite files of the recorded run.
+static std::string replay_init_data(const std::string &recorded) {
+    auto values = nlohmann::json::parse(recorded, nullptr, false);
+    if (values.is_discarded() || !values.is_object()) {
+        return recorded;
+    }
+    values.erase("trace_file");
+    values["log_file"] = "/dev/null";
+    values["decision_stats"] = false;
+    values["online_metrics"] = false;
+    return values.dump();
+}
+
+static void report_mismatch(size_t call, const MessageTrace::Call &expected, const uint8_t *decisions,
+                            uint32_t decisions_size, bool json_format) {
+    size_t common = std::min<size_t>(expected.decisions.size(), decisions_size);
+    size_t offset = 0;
+    while (offset < common && expected.decisions[offset] == decisions[offset]) {
+        ++offset;
+    }
+    printf("Decision mismatch at call %zu: expected %zu bytes, got %u bytes, first difference at byte %zu\n",
+           call, expected.decisions.size(), decisions_size, offset);
+    if (json_format) {
+        printf("  expected: %.*s\n", static_cast<int>(expected.decisions.size()),
+               reinterpret_cast<const char *>(expected.decisions.data()));
+        printf("  got:      %.*s\n", static_cast<int>(decisions_size), reinterpret_cast<const char *>(decisions));
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        printf("Usage: %s <trace_file> <lib.so> [--repeat n] [--no-check] [--init-data json]\n", argv[0]);
+        return 1;
+    }
+    std::string trace_path = argv[1];
+    std::string library_path = argv[2];
+    unsigned repeat = 1;
+    bool check = true;
+    bool custom_init_data = false;
+    std::string init_data;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--repeat" && i + 1 < argc) {
+            repeat = static_cast<unsigned>(std::max(1l, strtol(argv[++i], nullptr, 10)));
+        } else if (arg == "--no-check") {
+            check = false;
+        } else if (arg == "--init-data" && i + 1 < argc) {
+            init_data = argv[++i];
+            custom_init_data = true;
+        } else {
+            printf("Unknown option '%s'\n", arg.c_str());
+            return 1;
+        }
+    }
+
+    std::string error;
+    MessageTrace trace;
+    if (!load_message_trace(trace_path, trace, error)) {
+        printf("Error: %s\n", error.c_str());
+        return 1;
+    }
+    if (!custom_init_data) {
+        init_data = replay_init_data(trace.init_data);
+    }
+    const bool json_format = (trace.flags & BATSIM_EDC_FORMAT_JSON) != 0;
+
+    EdcLibrary edc;
+    if (!edc.load(library_path, "", error)) {
+        printf("Error: %s\n", error.c_str());
+        return 1;
+    }
+
+    printf("Replaying %zu calls of %s into %s\n", trace.calls.size(), trace_path.c_str(), library_path.c_str());
+
+    LogHistogram latencies;
+    size_t nb_mismatches = 0;
+    for (unsigned repetition = 0; repetition < repeat; ++repetition) {
+        if (edc.init(reinterpret_cast<const uint8_t *>(init_data.c_str()),
+                     static_cast<uint32_t>(init_data.size()), trace.flags) != 0) {
+            printf("Error: batsim_edc_init failed\n");
+            return 1;
+        }
+
+        auto replay_begin = std::chrono::steady_clock::now();
+        for (size_t call = 0; call < trace.calls.size(); ++call) {
+            const MessageTrace::Call &recorded = trace.calls[call];
+            uint8_t *decisions = nullptr;
+            uint32_t decisions_size = 0;
+
+            auto begin = std::chrono::steady_clock::now();
+            uint8_t status = edc.take_decisions(recorded.what_happened.data(),
+                                                static_cast<uint32_t>(recorded.what_happened.size()),
+                                                &decisions, &decisions_size);
+            auto end = std::chrono::steady_clock::now();
+            latencies.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()));
+
+            if (status != 0) {
+                printf("Error: batsim_edc_take_decisions failed at call %zu\n", call);
+                return 1;
+            }
+            if (check && (decisions_size != recorded.decisions.size()
+                          || memcmp(decisions, recorded.decisions.data(), decisions_size) != 0)) {
+                if (nb_mismatches == 0) {
+                    report_mismatch(call, recorded, decisions, decisions_size, json_format);
+                }
+                nb_mismatches++;
+            }
+        }
+        auto replay_end = std::chrono::steady_clock::now();
+
+        if (edc.deinit() != 0) {
+            printf("Error: batsim_edc_deinit failed\n");
+            return 1;
+        }
+        printf("Repetition %u: %.3f ms\n", repetition + 1,
+               std::chrono::duration<double, std::milli>(replay_end - replay_begin).count());
+    }
+
+    printf("Decision latency (ns): mean %.0f, p50 %llu, p90 %llu, p99 %llu, max %llu\n", latencies.mean(),
+           static_cast<unsigned long long>(latencies.quantile(0.5)),
+           static_cast<unsigned long long>(latencies.quantile(0.9)),
+           static_cast<unsigned long long>(latencies.quantile(0.99)),
+           static_cast<unsigned long long>(latencies.max()));
+
+    if (!check) {
+        return 0;
+    }
+    if (nb_mismatches > 0) {
+        printf("FAILED: %zu decisions differ from the trace\n", nb_mismatches);
+        return 1;
+    }
+    printf("OK: all %zu decisions are identical to the trace\n", trace.calls.size() * repeat);
+    return 0;
+}
@@ -0,0 +1,155 @@
+// scale_bench.cpp
+//
+// Scaling benchmark of a whole scheduler: runs bursts of jobs of growing size (all submitted in the
+// first 10 seconds, so that the queue holds nearly every job) in the in-process simulator and
+// reports the time of the simulation, mostly spent in the decisions. Jobs finish well before their
+// walltime (after 5 to 100% of it), so the time-aware schedulers keep re-planning their queue.
+// Every result is printed as one JSON object per line:
+//   {"bench": "burst", "library": "build/libbasic.so", "jobs": 1000, "hosts": 64,
+//    "decision_calls": 1634, "seconds": 2.48, "us_per_call": 1517.1, "mean_waiting_time": 56893.1,
+//    "status": "ok"}
+// "us_per_call" grows with the queue; comparing its growth between two builds shows a decision
+// that started walking the whole queue more often.
+// Once a point takes longer than --max-seconds, the larger ones are reported with "status": "skipped".
+//
+// Usage: scale_bench [--library lib.so] [--jobs n,..] [--hosts n] [--seed s] [--init-data json]
+//                    [--max-seconds s]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "simulator.hpp"
+#include "workload.hpp"
+
+struct ScaleOptions {
+    std::string library = "build/libbasic.so";
+    std::vector<uint32_t> jobs = {250, 500, 1000, 2000, 4000};
+    uint32_t hosts = 64;
+    uint64_t seed = 1;
+    std::string init_data = "{\"online_metrics\": false}";
+    double max_seconds = 60;
+};
+
+static bool parse_list(const std::string &text, std::vector<uint32_t> &values) {
+    values.clear();
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        char *end = nullptr;
+        unsigned long value = strtoul(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || value == 0) {
+            return false;
+        }
+        values.push_back(static_cast<uint32_t>(value));
+    }
+    return !values.empty();
+}
+
+// A burst of num_jobs jobs of 1 to hosts hosts and 100 s to ~3 h of walltime.
+static Workload burst_workload(uint32_t num_jobs, uint32_t hosts, uint64_t seed) {
+    GeneratorSettings settings;
+    std::string error;
+    settings.max_hosts = hosts;
+    parse_distribution("loguniform:1:" + std::to_string(hosts), settings.res, error);
+    parse_distribution("loguniform:100:10000", settings.walltime, error);
+    parse_distribution("uniform:0:10", settings.subtime, error);
+    JobGenerator generator(settings, seed);
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> fraction(0.05, 1.0);
+
+    Workload workload;
+    workload.nb_res = hosts;
+    workload.jobs.resize(num_jobs);
+    for (WorkloadJob &job : workload.jobs) {
+        generator.next(job);
+        job.delay = std::max(1.0, std::floor(job.walltime * fraction(rng)));
+    }
+    return workload;
+}
+
+static void print_point(const ScaleOptions &options, uint32_t num_jobs) {
+    printf("{\"bench\": \"burst\", \"library\": \"%s\", \"jobs\": %u, \"hosts\": %u, ", options.library.c_str(),
+           num_jobs, options.hosts);
+}
+
+static void print_usage(const char *program) {
+    printf("Usage: %s [--library lib.so] [--jobs n,..] [--hosts n] [--seed s] [--init-data json] [--max-seconds s]\n",
+           program);
+}
+
+int main(int argc, char **argv) {
+    ScaleOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help" || i + 1 >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--library") {
+            options.library = value;
+        } else if (arg == "--jobs") {
+            if (!parse_list(value, options.jobs)) {
+                printf("Invalid --jobs '%s' (expected a comma-separated list of positive integers)\n", value.c_str());
+                return 1;
+            }
+        } else if (arg == "--hosts") {
+            options.hosts = static_cast<uint32_t>(strtoul(value.c_str(), nullptr, 10));
+            if (options.hosts == 0) {
+                printf("Invalid --hosts '%s'\n", value.c_str());
+                return 1;
+            }
+        } else if (arg == "--seed") {
+            options.seed = std::stoull(value);
+        } else if (arg == "--init-data") {
+            options.init_data = value;
+        } else if (arg == "--max-seconds") {
+            options.max_seconds = std::stod(value);
+        } else {
+            printf("Unknown option '%s'\n", arg.c_str());
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    EdcLibrary edc;
+    std::string error;
+    if (!edc.load(options.library, "", error)) {
+        printf("Error: %s\n", error.c_str());
+        return 1;
+    }
+
+    bool too_slow = false;
+    for (uint32_t num_jobs : options.jobs) {
+        if (too_slow) {
+            print_point(options, num_jobs);
+            printf("\"decision_calls\": 0, \"seconds\": null, \"us_per_call\": null, \"mean_waiting_time\": null, "
+                   "\"status\": \"skipped\", \"reason\": \"a smaller point exceeded --max-seconds\"}\n");
+            fflush(stdout);
+            continue;
+        }
+        Workload workload = burst_workload(num_jobs, options.hosts, options.seed);
+        auto begin = std::chrono::steady_clock::now();
+        SimulationResult result = simulate(edc, workload, options.hosts, options.init_data);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        if (!result.success) {
+            printf("Error: %u jobs: %s\n", num_jobs, result.error.c_str());
+            return 1;
+        }
+        print_point(options, num_jobs);
+        printf("\"decision_calls\": %u, \"seconds\": %.3f, \"us_per_call\": %.1f, \"mean_waiting_time\": %.1f, "
+               "\"status\": \"ok\"}\n",
+               result.nb_decision_calls, elapsed, elapsed * 1e6 / std::max(1u, result.nb_decision_calls),
+               result.mean_waiting_time);
+        fflush(stdout);
+        too_slow = elapsed > options.max_seconds;
+    }
+    return 0;
+}
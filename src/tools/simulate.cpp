@@ -0,0 +1,89 @@
+// simulate.cpp
+//
+// Runs one workload file with one scheduler library in the in-process simulator (simulator.hpp),
+// e.g. for scale tests that Batsim would take far too long to run.
+// Binary workloads (binary_workload.hpp, made by workload2bin) are mapped and used in place;
+// JSON workloads are loaded with nlohmann_json.
+//
+// Usage: simulate <lib.so> <workload> [--hosts n] [--init-data json]
+//   --hosts n          platform size (default: nb_res of the workload)
+//   --init-data json   initialization data given to the scheduler
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "binary_workload.hpp"
+#include "simulator.hpp"
+#include "workload.hpp"
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        printf("Usage: %s <lib.so> <workload> [--hosts n] [--init-data json]\n", argv[0]);
+        return 1;
+    }
+    std::string library_path = argv[1];
+    std::string workload_path = argv[2];
+    uint32_t nb_hosts = 0;
+    std::string init_data;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--hosts" && i + 1 < argc) {
+            nb_hosts = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--init-data" && i + 1 < argc) {
+            init_data = argv[++i];
+        } else {
+            printf("Unknown option '%s'\n", arg.c_str());
+            return 1;
+        }
+    }
+
+    std::string error;
+    auto load_begin = std::chrono::steady_clock::now();
+    std::unique_ptr<JobTable> jobs;
+    uint32_t nb_res = 0;
+    if (is_binary_workload(workload_path)) {
+        auto mapped = std::make_unique<MappedWorkload>();
+        if (!mapped->open(workload_path, error)) {
+            printf("Error: %s\n", error.c_str());
+            return 1;
+        }
+        nb_res = mapped->nb_res();
+        jobs = std::move(mapped);
+    } else {
+        auto loaded = std::make_unique<Workload>();
+        if (!load_workload_json(workload_path, *loaded, error)) {
+            printf("Error: %s\n", error.c_str());
+            return 1;
+        }
+        nb_res = loaded->nb_res;
+        jobs = std::move(loaded);
+    }
+    auto load_end = std::chrono::steady_clock::now();
+    if (nb_hosts == 0) {
+        nb_hosts = nb_res;
+    }
+
+    EdcLibrary edc;
+    if (!edc.load(library_path, "", error)) {
+        printf("Error: %s\n", error.c_str());
+        return 1;
+    }
+
+    printf("Loaded %zu jobs in %.3f s, simulating on %u hosts\n", jobs->nb_jobs(),
+           std::chrono::duration<double>(load_end - load_begin).count(), nb_hosts);
+    SimulationResult result = simulate(edc, *jobs, nb_hosts, init_data);
+    auto simulation_end = std::chrono::steady_clock::now();
+
+    printf("Simulated in %.3f s (%u decision calls)\n",
+           std::chrono::duration<double>(simulation_end - load_end).count(), result.nb_decision_calls);
+    if (!result.success) {
+        printf("FAILED: %s\n", result.error.c_str());
+        return 1;
+    }
+    printf("makespan %.6g, mean waiting time %.6g, %u finished (%u killed), %u rejected\n", result.makespan,
+           result.mean_waiting_time, result.nb_jobs_finished, result.nb_jobs_killed, result.nb_jobs_rejected);
+    return 0;
+}
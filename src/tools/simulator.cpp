@@ -0,0 +1,396 @@
+// simulator.cpp
+//
+// In-process simulation of Batsim for the native tools, see simulator.hpp.
+
+#include "simulator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <dlfcn.h>
+#include <nlohmann/json.hpp>
+
+#include "../batsim_edc.h"
+
+using json = nlohmann::json;
+
+// -------------------------
+// Library loading
+// -------------------------
+EdcLibrary::~EdcLibrary() {
+    if (handle_ != nullptr) {
+        dlclose(handle_);
+    }
+    if (!private_path_.empty()) {
+        std::error_code ignored;
+        std::filesystem::remove(private_path_, ignored);
+    }
+}
+
+bool EdcLibrary::load(const std::string &path, const std::string &private_dir, std::string &error) {
+    std::string load_path = path;
+    if (!private_dir.empty()) {
+        static std::atomic<unsigned> copy_counter{0};
+        std::filesystem::path copy = std::filesystem::path(private_dir)
+            / (std::to_string(copy_counter++) + "_" + std::filesystem::path(path).filename().string());
+        std::error_code ec;
+        std::filesystem::copy_file(path, copy, std::filesystem::copy_options::overwrite_existing, ec);
+        if (ec) {
+            error = "cannot copy '" + path + "': " + ec.message();
+            return false;
+        }
+        private_path_ = copy.string();
+        load_path = private_path_;
+    }
+
+    handle_ = dlopen(load_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle_ == nullptr) {
+        error = dlerror();
+        return false;
+    }
+
+    init = reinterpret_cast<InitFunction>(dlsym(handle_, "batsim_edc_init"));
+    deinit = reinterpret_cast<DeinitFunction>(dlsym(handle_, "batsim_edc_deinit"));
+    take_decisions = reinterpret_cast<TakeDecisionsFunction>(dlsym(handle_, "batsim_edc_take_decisions"));
+    if (init == nullptr || deinit == nullptr || take_decisions == nullptr) {
+        error = "'" + path + "' does not export the batsim_edc_* functions";
+        return false;
+    }
+    return true;
+}
+
+// -------------------------
+// Simulation
+// -------------------------
+namespace {
+
+// Batsim prefixes job and profile ids with the workload name.
+const std::string workload_prefix = "w0!";
+
+struct RunningJob {
+    double finish_time;
+    size_t job;
+    bool killed;
+
+    bool operator>(const RunningJob &other) const {
+        if (finish_time != other.finish_time) {
+            return finish_time > other.finish_time;
+        }
+        return job > other.job;
+    }
+};
+
+// A one-shot call the scheduler asked for with a CallMeLaterEvent.
+struct RequestedCall {
+    double time;
+    std::string id;
+
+    bool operator>(const RequestedCall &other) const {
+        if (time != other.time) {
+            return time > other.time;
+        }
+        return id > other.id;
+    }
+};
+
+json make_event(double timestamp, const char *type, json body) {
+    return json{{"timestamp", timestamp}, {"event_type", type}, {"event", std::move(body)}};
+}
+
+// Accepts Batsim's host allocation strings: "0-3 6", "0-3,6" or "0,1,2,3,6".
+bool parse_host_allocation(const std::string &text, std::vector<uint32_t> &hosts) {
+    hosts.clear();
+    size_t pos = 0;
+    while (pos < text.size()) {
+        if (text[pos] == ' ' || text[pos] == ',') {
+            ++pos;
+            continue;
+        }
+        char *end = nullptr;
+        unsigned long first = strtoul(text.c_str() + pos, &end, 10);
+        if (end == text.c_str() + pos) {
+            return false;
+        }
+        pos = end - text.c_str();
+        unsigned long last = first;
+        if (pos < text.size() && text[pos] == '-') {
+            ++pos;
+            last = strtoul(text.c_str() + pos, &end, 10);
+            if (end == text.c_str() + pos || last < first) {
+                return false;
+            }
+            pos = end - text.c_str();
+        }
+        for (unsigned long host = first; host <= last; ++host) {
+            hosts.push_back(static_cast<uint32_t>(host));
+        }
+    }
+    return true;
+}
+
+class Simulation {
+public:
+    Simulation(EdcLibrary &edc, const JobTable &jobs, uint32_t nb_hosts)
+        : edc_(edc), jobs_(jobs), nb_hosts_(nb_hosts),
+          busy_(nb_hosts, false), start_times_(jobs.nb_jobs(), -1),
+          allocations_(jobs.nb_jobs()) {
+        // The views point into the job table, which outlives the simulation.
+        job_index_.reserve(jobs.nb_jobs());
+        for (size_t i = 0; i < jobs.nb_jobs(); ++i) {
+            job_index_[jobs.job_id(i)] = i;
+        }
+        submission_order_.resize(jobs.nb_jobs());
+        std::iota(submission_order_.begin(), submission_order_.end(), 0);
+        auto by_subtime = [&](size_t a, size_t b) { return jobs.job_subtime(a) < jobs.job_subtime(b); };
+        if (!std::is_sorted(submission_order_.begin(), submission_order_.end(), by_subtime)) {
+            std::stable_sort(submission_order_.begin(), submission_order_.end(), by_subtime);
+        }
+    }
+
+    SimulationResult run(const std::string &init_data) {
+        if (edc_.init(reinterpret_cast<const uint8_t *>(init_data.c_str()),
+                      static_cast<uint32_t>(init_data.size()), BATSIM_EDC_FORMAT_JSON) != 0) {
+            result_.error = "batsim_edc_init failed";
+            return result_;
+        }
+
+        bool ok = run_events();
+        if (ok) {
+            // Let the scheduler know that we are done, its decisions do not matter anymore.
+            json events = json::array({make_event(now_, "SimulationEndsEvent", json::object())});
+            ok = exchange(events, false);
+        }
+        if (edc_.deinit() != 0 && ok) {
+            result_.error = "batsim_edc_deinit failed";
+            ok = false;
+        }
+
+        uint32_t nb_started = result_.nb_jobs_finished;
+        if (ok && nb_started + result_.nb_jobs_rejected != jobs_.nb_jobs()) {
+            result_.error = std::to_string(jobs_.nb_jobs() - nb_started - result_.nb_jobs_rejected)
+                + " jobs were never executed";
+            ok = false;
+        }
+
+        double waiting_sum = 0;
+        for (size_t i = 0; i < jobs_.nb_jobs(); ++i) {
+            if (start_times_[i] >= 0) {
+                waiting_sum += start_times_[i] - jobs_.job_subtime(i);
+            }
+        }
+        if (result_.nb_jobs_finished > 0) {
+            result_.mean_waiting_time = waiting_sum / result_.nb_jobs_finished;
+        }
+        result_.success = ok;
+        return result_;
+    }
+
+private:
+    bool run_events() {
+        json events = json::array({make_event(0, "BatsimHelloEvent", json{{"batsim_version", "rmse-simulator"}})});
+        if (!exchange(events, true)) {
+            return false;
+        }
+
+        events.push_back(make_event(0, "SimulationBeginsEvent", json{{"computation_host_number", nb_hosts_}}));
+        if (!exchange(events, true)) {
+            return false;
+        }
+
+        size_t next_submission = 0;
+        const double never = std::numeric_limits<double>::infinity();
+        while (true) {
+            double next_time = never;
+            if (next_submission < submission_order_.size()) {
+                next_time = jobs_.job_subtime(submission_order_[next_submission]);
+            }
+            if (!running_.empty()) {
+                next_time = std::min(next_time, running_.top().finish_time);
+            }
+            if (!calls_.empty()) {
+                next_time = std::min(next_time, calls_.top().time);
+            }
+            if (next_time == never) {
+                return true;
+            }
+            now_ = std::max(now_, next_time);
+
+            while (!running_.empty() && running_.top().finish_time <= now_) {
+                RunningJob done = running_.top();
+                running_.pop();
+                for (uint32_t host : allocations_[done.job]) {
+                    busy_[host] = false;
+                }
+                result_.nb_jobs_finished++;
+                if (done.killed) {
+                    result_.nb_jobs_killed++;
+                }
+                result_.makespan = std::max(result_.makespan, done.finish_time);
+                events.push_back(make_event(now_, "JobCompletedEvent", json{
+                    {"job_id", prefixed(jobs_.job_id(done.job))},
+                    {"state", done.killed ? "COMPLETED_WALLTIME_REACHED" : "COMPLETED_SUCCESSFULLY"},
+                    {"return_code", 0}}));
+            }
+
+            while (next_submission < submission_order_.size()
+                   && jobs_.job_subtime(submission_order_[next_submission]) <= now_) {
+                size_t job = submission_order_[next_submission++];
+                json body = {
+                    {"job_id", prefixed(jobs_.job_id(job))},
+                    {"job", json{{"profile_id", prefixed(jobs_.job_profile(job))},
+                                 {"resource_request", jobs_.job_res(job)},
+                                 {"walltime", jobs_.job_walltime(job)}}}};
+                events.push_back(make_event(now_, "JobSubmittedEvent", std::move(body)));
+            }
+
+            while (!calls_.empty() && calls_.top().time <= now_) {
+                events.push_back(make_event(now_, "RequestedCallEvent", json{
+                    {"call_me_later_id", calls_.top().id}, {"last_periodic_call", false}}));
+                calls_.pop();
+            }
+
+            if (!exchange(events, true)) {
+                return false;
+            }
+        }
+    }
+
+    // Sends the pending events to the scheduler and applies its decisions.
+    bool exchange(json &events, bool apply) {
+        json message = {{"now", now_}, {"events", std::move(events)}};
+        events = json::array();
+        std::string text = message.dump();
+
+        uint8_t *answer = nullptr;
+        uint32_t answer_size = 0;
+        result_.nb_decision_calls++;
+        if (edc_.take_decisions(reinterpret_cast<const uint8_t *>(text.c_str()),
+                                static_cast<uint32_t>(text.size() + 1), &answer, &answer_size) != 0) {
+            result_.error = "batsim_edc_take_decisions failed at time " + std::to_string(now_);
+            return false;
+        }
+        if (!apply) {
+            return true;
+        }
+
+        std::string answer_text(reinterpret_cast<const char *>(answer), answer_size);
+        while (!answer_text.empty() && answer_text.back() == '\0') {
+            answer_text.pop_back();
+        }
+        json decisions = json::parse(answer_text, nullptr, false);
+        if (decisions.is_discarded() || !decisions.contains("events")) {
+            result_.error = "cannot parse the decisions taken at time " + std::to_string(now_);
+            return false;
+        }
+
+        for (const auto &decision : decisions["events"]) {
+            std::string type = decision.value("event_type", "");
+            if (type == "ExecuteJobEvent") {
+                if (!execute_job(decision["event"])) {
+                    return false;
+                }
+            } else if (type == "RejectJobEvent") {
+                result_.nb_jobs_rejected++;
+            } else if (type == "CallMeLaterEvent") {
+                if (!call_me_later(decision["event"])) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool execute_job(const json &decision) {
+        std::string job_id = decision.value("job_id", "");
+        auto it = job_index_.end();
+        if (job_id.compare(0, workload_prefix.size(), workload_prefix) == 0) {
+            it = job_index_.find(std::string_view(job_id).substr(workload_prefix.size()));
+        }
+        if (it == job_index_.end() || start_times_[it->second] >= 0) {
+            result_.error = "invalid execution of job '" + job_id + "' at time " + std::to_string(now_);
+            return false;
+        }
+        size_t job = it->second;
+
+        std::string allocation;
+        if (decision.contains("allocation") && decision["allocation"].is_object()) {
+            allocation = decision["allocation"].value("host_allocation", "");
+        }
+        std::vector<uint32_t> &hosts = allocations_[job];
+        if (!parse_host_allocation(allocation, hosts) || hosts.size() != jobs_.job_res(job)) {
+            result_.error = "job '" + job_id + "' executed on '" + allocation + "' but requested "
+                + std::to_string(jobs_.job_res(job)) + " hosts";
+            return false;
+        }
+        for (uint32_t host : hosts) {
+            if (host >= nb_hosts_ || busy_[host]) {
+                result_.error = "job '" + job_id + "' executed on busy or unknown host " + std::to_string(host)
+                    + " at time " + std::to_string(now_);
+                return false;
+            }
+            busy_[host] = true;
+        }
+
+        double walltime = jobs_.job_walltime(job), delay = jobs_.job_delay(job);
+        bool killed = walltime > 0 && delay > walltime;
+        double duration = killed ? walltime : delay;
+        start_times_[job] = now_;
+        running_.push(RunningJob{now_ + duration, job, killed});
+        return true;
+    }
+
+    // Only one-shot calls: no scheduler of this project asks for periodic ones.
+    bool call_me_later(const json &decision) {
+        std::string id = decision.value("call_me_later_id", "");
+        const json when = decision.value("when", json::object());
+        if (decision.value("when_type", "OneShot") != "OneShot" || !when.contains("time")
+            || !when["time"].is_number()) {
+            result_.error = "unsupported call me later '" + id + "' at time " + std::to_string(now_);
+            return false;
+        }
+        double time = when["time"].get<double>();
+        if (decision.value("time_unit", "Second") == "Millisecond") {
+            time /= 1000;
+        }
+        // Batsim calls back right away when the requested time has already passed.
+        calls_.push(RequestedCall{std::max(time, now_), id});
+        return true;
+    }
+
+    static std::string prefixed(std::string_view id) {
+        std::string text = workload_prefix;
+        text.append(id.data(), id.size());
+        return text;
+    }
+
+    EdcLibrary &edc_;
+    const JobTable &jobs_;
+    uint32_t nb_hosts_;
+    double now_ = 0;
+
+    std::vector<size_t> submission_order_;
+    std::unordered_map<std::string_view, size_t> job_index_;
+    std::vector<bool> busy_;
+    std::vector<double> start_times_;
+    std::vector<std::vector<uint32_t>> allocations_;
+    std::priority_queue<RunningJob, std::vector<RunningJob>, std::greater<RunningJob>> running_;
+    std::priority_queue<RequestedCall, std::vector<RequestedCall>, std::greater<RequestedCall>> calls_;
+
+    SimulationResult result_;
+};
+
+} // namespace
+
+SimulationResult simulate(EdcLibrary &edc, const JobTable &jobs, uint32_t nb_hosts, const std::string &init_data) {
+    Simulation simulation(edc, jobs, nb_hosts);
+    return simulation.run(init_data);
+}
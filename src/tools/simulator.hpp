@@ -0,0 +1,56 @@
+// simulator.hpp
+//
+// A minimal in-process replacement for Batsim, good enough to drive the schedulers of this project.
+// The scheduler library is loaded with dlopen and called through the EDC C API (batsim_edc.h),
+// exchanging flatbuffers JSON messages exactly like Batsim does with a library loaded in JSON mode.
+//
+// Only what the schedulers use is simulated: delay profiles on dedicated hosts, rejection,
+// walltime kills and one-shot call me later requests. There is no network, no energy and no platform file (hosts are 0..n-1).
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "workload.hpp"
+
+// A scheduler library loaded in the current process.
+class EdcLibrary {
+public:
+    typedef uint8_t (*InitFunction)(const uint8_t *, uint32_t, uint32_t);
+    typedef uint8_t (*DeinitFunction)();
+    typedef uint8_t (*TakeDecisionsFunction)(const uint8_t *, uint32_t, uint8_t **, uint32_t *);
+
+    EdcLibrary() = default;
+    ~EdcLibrary();
+    EdcLibrary(const EdcLibrary &) = delete;
+    EdcLibrary &operator=(const EdcLibrary &) = delete;
+
+    // The schedulers keep their state in globals, so dlopen-ing the same file twice would share it.
+    // When private_dir is not empty, the library is copied there first and the copy is loaded,
+    // which gives this instance its own globals (one instance per worker thread).
+    bool load(const std::string &path, const std::string &private_dir, std::string &error);
+
+    InitFunction init = nullptr;
+    DeinitFunction deinit = nullptr;
+    TakeDecisionsFunction take_decisions = nullptr;
+
+private:
+    void *handle_ = nullptr;
+    std::string private_path_;
+};
+
+struct SimulationResult {
+    bool success = false;
+    std::string error;
+    double makespan = 0;
+    double mean_waiting_time = 0;
+    uint32_t nb_jobs_finished = 0;
+    uint32_t nb_jobs_killed = 0;    // reached their walltime
+    uint32_t nb_jobs_rejected = 0;
+    uint32_t nb_decision_calls = 0;
+};
+
+// Runs the whole workload (a Workload or a MappedWorkload) on nb_hosts hosts with the given scheduler.
+// init_data is passed verbatim to batsim_edc_init().
+SimulationResult simulate(EdcLibrary &edc, const JobTable &jobs, uint32_t nb_hosts, const std::string &init_data);
@@ -0,0 +1,269 @@
+// sweep.cpp
+//
+// Native replacement for the simulation loop of scripts/makespan.py.
+// Runs a grid of (algorithm x number of jobs x number of machines x simulation) with the
+// in-process simulator, on a work-stealing thread pool that uses every core by default.
+// Each worker thread loads its own private copy of every scheduler library, since the
+// schedulers keep their state in globals.
+//
+// Outputs the same files as makespan.py:
+//   res/makespan/<algorithm>_temp.txt  "<simulation_number> <makespan>"
+//   res/backfill/<algorithm>_temp.txt  "<simulation_number> (<total>, <contiguous>, <non_contiguous>)"
+// When the grid has more than one (jobs, machines) point, the point is added to the file name:
+//   res/makespan/<algorithm>_<jobs>_<machines>_temp.txt
+//
+// Usage: sweep [--algorithms a,b,..] [--jobs n,..] [--machines n,..] [--num-sims n]
+//              [--seed s] [--threads n] [--lib-dir build] [--res-dir res]
+
+#include <unistd.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../thread_pool.hpp"
+#include "simulator.hpp"
+#include "workload.hpp"
+
+namespace fs = std::filesystem;
+
+struct SweepOptions {
+    std::vector<std::string> algorithms = {"easy_backfill", "basic", "best_cont", "force_cont"};
+    std::vector<uint32_t> jobs = {256};
+    std::vector<uint32_t> machines = {8};
+    uint32_t num_sims = 512;
+    uint64_t seed = 1;
+    unsigned threads = 0;
+    std::string lib_dir = "build";
+    std::string res_dir = "res";
+};
+
+struct RunOutcome {
+    bool makespan_ok = false;
+    double makespan = 0;
+    bool backfill_ok = false;
+    uint32_t backfill[3] = {0, 0, 0};
+};
+
+static std::vector<std::string> split(const std::string &text, char separator) {
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, separator)) {
+        if (!part.empty()) {
+            parts.push_back(part);
+        }
+    }
+    return parts;
+}
+
+static std::vector<uint32_t> split_numbers(const std::string &text) {
+    std::vector<uint32_t> numbers;
+    for (const auto &part : split(text, ',')) {
+        numbers.push_back(static_cast<uint32_t>(std::stoul(part)));
+    }
+    return numbers;
+}
+
+static void print_usage(const char *program) {
+    printf("Usage: %s [--algorithms a,b,..] [--jobs n,..] [--machines n,..] [--num-sims n]\n", program);
+    printf("          [--seed s] [--threads n] [--lib-dir build] [--res-dir res]\n");
+    printf("Example: %s --algorithms basic,force_cont --jobs 256,512 --machines 8 --num-sims 512\n", program);
+}
+
+static bool parse_options(int argc, char **argv, SweepOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help" || i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--algorithms") {
+            options.algorithms = split(value, ',');
+        } else if (arg == "--jobs") {
+            options.jobs = split_numbers(value);
+        } else if (arg == "--machines") {
+            options.machines = split_numbers(value);
+        } else if (arg == "--num-sims") {
+            options.num_sims = static_cast<uint32_t>(std::stoul(value));
+        } else if (arg == "--seed") {
+            options.seed = std::stoull(value);
+        } else if (arg == "--threads") {
+            options.threads = static_cast<unsigned>(std::stoul(value));
+        } else if (arg == "--lib-dir") {
+            options.lib_dir = value;
+        } else if (arg == "--res-dir") {
+            options.res_dir = value;
+        } else {
+            printf("Unknown option '%s'\n", arg.c_str());
+            return false;
+        }
+    }
+    return !options.algorithms.empty() && !options.jobs.empty() && !options.machines.empty();
+}
+
+// Same as extract_backfill_stats() in scripts/analyze_scheduler_performance.py: the last line wins.
+static bool extract_backfill_stats(const std::string &log_path, uint32_t stats[3]) {
+    std::ifstream log(log_path);
+    if (!log.is_open()) {
+        return false;
+    }
+    std::string line, last;
+    while (std::getline(log, line)) {
+        if (!line.empty()) {
+            last = line;
+        }
+    }
+    return sscanf(last.c_str(), "%" SCNu32 " %" SCNu32 " %" SCNu32, &stats[0], &stats[1], &stats[2]) == 3;
+}
+
+// Python's repr() of a float, which is what makespan.py writes.
+static std::string python_float(double value) {
+    char buffer[64];
+    if (value == static_cast<double>(static_cast<int64_t>(value)) && value < 1e16 && value > -1e16) {
+        snprintf(buffer, sizeof(buffer), "%.1f", value);
+        return buffer;
+    }
+    for (int precision = 1; precision <= 17; ++precision) {
+        snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        if (strtod(buffer, nullptr) == value) {
+            break;
+        }
+    }
+    return buffer;
+}
+
+int main(int argc, char **argv) {
+    SweepOptions options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    fs::path private_dir = fs::temp_directory_path() / ("rmse_sweep_" + std::to_string(getpid()));
+    fs::create_directories(private_dir);
+    fs::create_directories(fs::path(options.res_dir) / "makespan");
+    fs::create_directories(fs::path(options.res_dir) / "backfill");
+
+    const size_t nb_algorithms = options.algorithms.size();
+    const size_t nb_points = options.jobs.size() * options.machines.size();
+    const size_t nb_runs = nb_points * options.num_sims * nb_algorithms;
+    std::vector<RunOutcome> outcomes(nb_runs);
+
+    ThreadPool pool(options.threads);
+    printf("Running %zu simulations on %u threads\n", nb_runs, pool.size());
+
+    // One set of private scheduler instances per worker, only ever touched by that worker.
+    std::vector<std::map<std::string, std::unique_ptr<EdcLibrary>>> libraries(pool.size());
+    std::mutex print_mutex;
+    size_t nb_done = 0;
+
+    for (size_t point = 0; point < nb_points; ++point) {
+        uint32_t num_jobs = options.jobs[point / options.machines.size()];
+        uint32_t num_machines = options.machines[point % options.machines.size()];
+
+        for (uint32_t sim = 0; sim < options.num_sims; ++sim) {
+            // The workload of a simulation is generated once and shared by all the algorithms,
+            // each algorithm being its own task so that idle workers can steal it.
+            pool.submit([&, point, num_jobs, num_machines, sim]() {
+                uint64_t seed = options.seed + (static_cast<uint64_t>(point) << 32) + sim;
+                auto workload = std::make_shared<const Workload>(generate_workload(num_jobs, num_machines, seed));
+
+                for (size_t algo = 0; algo < nb_algorithms; ++algo) {
+                    pool.submit([&, workload, point, num_jobs, num_machines, sim, algo]() {
+                        const std::string &algorithm = options.algorithms[algo];
+                        RunOutcome &outcome = outcomes[(point * options.num_sims + sim) * nb_algorithms + algo];
+
+                        auto &edc = libraries[ThreadPool::current_worker()][algorithm];
+                        std::string error;
+                        if (edc == nullptr) {
+                            edc = std::make_unique<EdcLibrary>();
+                            std::string lib_path = options.lib_dir + "/lib" + algorithm + ".so";
+                            if (!edc->load(lib_path, private_dir.string(), error)) {
+                                edc.reset();
+                            }
+                        }
+
+                        std::string log_path = (private_dir / (algorithm + "_" + std::to_string(point) + "_"
+                            + std::to_string(sim) + "_log.txt")).string();
+                        if (edc != nullptr) {
+                            // Concurrent runs would all write the same decision statistics and
+                            // online metrics files.
+                            std::string init_data = "{\"log_file\": \"" + log_path
+                                + "\", \"decision_stats\": false, \"online_metrics\": false}";
+                            SimulationResult result = simulate(*edc, *workload, num_machines, init_data);
+                            outcome.makespan_ok = result.success;
+                            outcome.makespan = result.makespan;
+                            error = result.error;
+                        }
+                        outcome.backfill_ok = extract_backfill_stats(log_path, outcome.backfill);
+                        std::error_code ignored;
+                        fs::remove(log_path, ignored);
+
+                        std::lock_guard<std::mutex> lock(print_mutex);
+                        ++nb_done;
+                        if (outcome.makespan_ok) {
+                            printf("[%zu/%zu] %s jobs=%u machines=%u sim=%u makespan=%s\n", nb_done, nb_runs,
+                                   algorithm.c_str(), num_jobs, num_machines, sim + 1,
+                                   python_float(outcome.makespan).c_str());
+                        } else {
+                            printf("[%zu/%zu] %s jobs=%u machines=%u sim=%u FAILED: %s\n", nb_done, nb_runs,
+                                   algorithm.c_str(), num_jobs, num_machines, sim + 1, error.c_str());
+                        }
+                    });
+                }
+            });
+        }
+    }
+    pool.wait_idle();
+    libraries.clear();
+
+    for (size_t point = 0; point < nb_points; ++point) {
+        uint32_t num_jobs = options.jobs[point / options.machines.size()];
+        uint32_t num_machines = options.machines[point % options.machines.size()];
+        std::string suffix = (nb_points == 1) ? ""
+            : "_" + std::to_string(num_jobs) + "_" + std::to_string(num_machines);
+
+        for (size_t algo = 0; algo < nb_algorithms; ++algo) {
+            const std::string &algorithm = options.algorithms[algo];
+            std::ofstream makespan_file(options.res_dir + "/makespan/" + algorithm + suffix + "_temp.txt");
+            std::ofstream backfill_file(options.res_dir + "/backfill/" + algorithm + suffix + "_temp.txt");
+
+            makespan_file << "# Makespan values for " << algorithm << " algorithm\n";
+            makespan_file << "# Number of jobs: " << num_jobs << ", Number of machines: " << num_machines << "\n";
+            makespan_file << "# Format: simulation_number, makespan\n";
+            backfill_file << "# Backfill values for " << algorithm << " algorithm\n";
+            backfill_file << "# Number of jobs: " << num_jobs << ", Number of machines: " << num_machines << "\n";
+            backfill_file << "# Format: simulation_number, total_backfills, contiguous_backfills, non_contiguous_backfills\n";
+
+            for (uint32_t sim = 0; sim < options.num_sims; ++sim) {
+                const RunOutcome &outcome = outcomes[(point * options.num_sims + sim) * nb_algorithms + algo];
+                if (outcome.makespan_ok) {
+                    makespan_file << sim + 1 << " " << python_float(outcome.makespan) << "\n";
+                } else {
+                    makespan_file << sim + 1 << " FAILED\n";
+                }
+                if (outcome.backfill_ok) {
+                    backfill_file << sim + 1 << " (" << outcome.backfill[0] << ", " << outcome.backfill[1]
+                                  << ", " << outcome.backfill[2] << ")\n";
+                } else {
+                    backfill_file << sim + 1 << " FAILED\n";
+                }
+            }
+        }
+    }
+
+    std::error_code ignored;
+    fs::remove_all(private_dir, ignored);
+    printf("\nAll simulations completed!\n");
+    return 0;
+}
@@ -0,0 +1,298 @@
+// swf2json.cpp
+//
+// Converts a Standard Workload Format trace (Parallel Workloads Archive, one job per line,
+// 18 whitespace-separated fields, ';' header comments) into a Batsim JSON workload with delay profiles.
+// The trace is streamed: memory is bounded by the number of distinct run times, not by the number of jobs.
+//
+//   res       requested processors (field 8), or allocated processors (field 5) if not given,
+//             divided by --cores-per-host (rounded up)
+//   walltime  requested time (field 9), or the run time if the user gave none
+//   delay     actual run time (field 4): the job is killed at its walltime if it ran longer
+//   subtime   submit time (field 2), rebased so that the first imported job is submitted at 0
+// Jobs sharing a run time share one "delay<run time>" profile.
+// Cancelled jobs (status 5) that never ran are dropped, those that ran are kept (they held their
+// hosts until cancelled), unless --drop-cancelled is given. Jobs without size or run time are dropped.
+// nb_res is --nb-res, else MaxProcs from the header, else the largest job of the trace.
+//
+// Usage: swf2json <trace.swf> <workload.json> [--nb-res n] [--cores-per-host n] [--drop-cancelled] [--max-jobs n]
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "json_output.hpp"
+
+struct ImportOptions {
+    std::string input;
+    std::string output;
+    int64_t nb_res = 0;
+    int64_t cores_per_host = 1;
+    bool drop_cancelled = false;
+    uint64_t max_jobs = 0;  // 0: no limit
+};
+
+struct ImportCounts {
+    uint64_t lines = 0;
+    uint64_t imported = 0;
+    uint64_t cancelled = 0;
+    uint64_t no_size = 0;
+    uint64_t no_runtime = 0;
+    uint64_t too_large = 0;
+    uint64_t unsorted = 0;
+};
+
+enum SwfField {
+    SWF_JOB_NUMBER = 0,
+    SWF_SUBMIT_TIME = 1,
+    SWF_RUN_TIME = 3,
+    SWF_ALLOCATED_PROCESSORS = 4,
+    SWF_REQUESTED_PROCESSORS = 7,
+    SWF_REQUESTED_TIME = 8,
+    SWF_STATUS = 10,
+    SWF_USED_FIELDS = 11
+};
+
+static const int64_t SWF_STATUS_CANCELLED = 5;
+
+// Reads the first SWF_USED_FIELDS fields of a data line. Missing fields are -1, as in the SWF convention.
+// Fractional values (some traces have them for times) are truncated.
+static void parse_fields(const char *line, int64_t fields[SWF_USED_FIELDS]) {
+    const char *p = line;
+    for (int i = 0; i < SWF_USED_FIELDS; ++i) {
+        while (*p == ' ' || *p == '\t') {
+            ++p;
+        }
+        if (*p == '\0' || *p == '\n' || *p == '\r') {
+            fields[i] = -1;
+            continue;
+        }
+        bool negative = (*p == '-');
+        if (negative) {
+            ++p;
+        }
+        int64_t value = 0;
+        while (*p >= '0' && *p <= '9') {
+            value = value * 10 + (*p - '0');
+            ++p;
+        }
+        // Fraction, exponent or garbage: skip to the end of the field.
+        while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') {
+            ++p;
+        }
+        fields[i] = negative ? -value : value;
+    }
+}
+
+static bool is_data_line(const char *line) {
+    const char *p = line;
+    while (*p == ' ' || *p == '\t') {
+        ++p;
+    }
+    return *p != ';' && *p != '\0' && *p != '\n' && *p != '\r';
+}
+
+static int64_t job_size(const int64_t fields[SWF_USED_FIELDS], int64_t cores_per_host) {
+    int64_t processors = fields[SWF_REQUESTED_PROCESSORS] > 0 ? fields[SWF_REQUESTED_PROCESSORS]
+                                                               : fields[SWF_ALLOCATED_PROCESSORS];
+    if (processors <= 0) {
+        return 0;
+    }
+    return (processors + cores_per_host - 1) / cores_per_host;
+}
+
+// nb_res must be written before the jobs: taken from the header, or from a first pass over the trace.
+static bool find_nb_res(const ImportOptions &options, int64_t &nb_res) {
+    FILE *input = fopen(options.input.c_str(), "r");
+    if (input == nullptr) {
+        return false;
+    }
+    char *line = nullptr;
+    size_t capacity = 0;
+    int64_t max_procs = 0, largest_job = 0;
+    int64_t fields[SWF_USED_FIELDS];
+    bool header = true;
+    while (getline(&line, &capacity, input) != -1) {
+        if (!is_data_line(line)) {
+            const char *key = strstr(line, "MaxProcs:");
+            if (header && key != nullptr) {
+                max_procs = strtoll(key + strlen("MaxProcs:"), nullptr, 10);
+            }
+            continue;
+        }
+        if (header && max_procs > 0) {
+            break;
+        }
+        header = false;
+        parse_fields(line, fields);
+        largest_job = std::max(largest_job, job_size(fields, options.cores_per_host));
+    }
+    free(line);
+    fclose(input);
+    nb_res = max_procs > 0 ? (max_procs + options.cores_per_host - 1) / options.cores_per_host : largest_job;
+    return true;
+}
+
+static std::string base_name(const std::string &path) {
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+static void print_usage(const char *program) {
+    printf("Usage: %s <trace.swf> <workload.json> [--nb-res n] [--cores-per-host n] [--drop-cancelled] [--max-jobs n]\n",
+           program);
+}
+
+static bool parse_options(int argc, char **argv, ImportOptions &options) {
+    if (argc < 3) {
+        return false;
+    }
+    options.input = argv[1];
+    options.output = argv[2];
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--drop-cancelled") {
+            options.drop_cancelled = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--nb-res") {
+            options.nb_res = std::stoll(value);
+        } else if (arg == "--cores-per-host") {
+            options.cores_per_host = std::max(1ll, std::stoll(value));
+        } else if (arg == "--max-jobs") {
+            options.max_jobs = std::stoull(value);
+        } else {
+            printf("Unknown option '%s'\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    ImportOptions options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    int64_t nb_res = options.nb_res;
+    if (nb_res <= 0 && !find_nb_res(options, nb_res)) {
+        printf("Error: cannot open '%s'\n", options.input.c_str());
+        return 1;
+    }
+
+    FILE *input = fopen(options.input.c_str(), "r");
+    if (input == nullptr) {
+        printf("Error: cannot open '%s'\n", options.input.c_str());
+        return 1;
+    }
+    FILE *output = fopen(options.output.c_str(), "wb");
+    if (output == nullptr) {
+        printf("Error: cannot open '%s' for writing\n", options.output.c_str());
+        fclose(input);
+        return 1;
+    }
+    setvbuf(input, nullptr, _IOFBF, 1 << 20);
+
+    ImportCounts counts;
+    // Profiles in order of first use, as a Python dict would keep them.
+    std::vector<int64_t> profiles;
+    std::unordered_set<int64_t> known_profiles;
+    bool ok = true;
+    {
+        JsonOutput out(output);
+        out.text("{\n  \"description\": ").string("Imported from " + base_name(options.input) + " (SWF)")
+           .text(",\n  \"nb_res\": ").number(static_cast<double>(nb_res))
+           .text(",\n  \"jobs\": [");
+
+        char *line = nullptr;
+        size_t capacity = 0;
+        int64_t fields[SWF_USED_FIELDS];
+        int64_t first_submit = -1;
+        while (getline(&line, &capacity, input) != -1) {
+            if (!is_data_line(line)) {
+                continue;
+            }
+            counts.lines++;
+            parse_fields(line, fields);
+
+            int64_t run_time = fields[SWF_RUN_TIME];
+            int64_t res = job_size(fields, options.cores_per_host);
+            if (fields[SWF_STATUS] == SWF_STATUS_CANCELLED && (options.drop_cancelled || run_time <= 0)) {
+                counts.cancelled++;
+                continue;
+            }
+            if (res <= 0) {
+                counts.no_size++;
+                continue;
+            }
+            if (run_time < 0) {
+                counts.no_runtime++;
+                continue;
+            }
+            if (res > nb_res) {
+                counts.too_large++;
+                continue;
+            }
+
+            if (first_submit < 0) {
+                first_submit = std::max<int64_t>(0, fields[SWF_SUBMIT_TIME]);
+            }
+            int64_t subtime = fields[SWF_SUBMIT_TIME] - first_submit;
+            if (subtime < 0) {
+                counts.unsorted++;
+                subtime = 0;
+            }
+            int64_t walltime = fields[SWF_REQUESTED_TIME] > 0 ? fields[SWF_REQUESTED_TIME] : run_time;
+            if (known_profiles.insert(run_time).second) {
+                profiles.push_back(run_time);
+            }
+
+            std::string run_time_text = std::to_string(run_time);
+            out.text(counts.imported == 0 ? "\n    {\n      \"id\": \"job" : ",\n    {\n      \"id\": \"job")
+               .text(std::to_string(fields[SWF_JOB_NUMBER]))
+               .text("\",\n      \"profile\": \"delay").text(run_time_text)
+               .text("\",\n      \"res\": ").number(static_cast<double>(res))
+               .text(",\n      \"walltime\": ").number(static_cast<double>(walltime))
+               .text(",\n      \"subtime\": ").number(static_cast<double>(subtime))
+               .text("\n    }");
+            counts.imported++;
+            if (options.max_jobs > 0 && counts.imported >= options.max_jobs) {
+                break;
+            }
+        }
+        free(line);
+
+        out.text(counts.imported == 0 ? "],\n  \"profiles\": {" : "\n  ],\n  \"profiles\": {");
+        for (size_t i = 0; i < profiles.size(); ++i) {
+            out.text(i == 0 ? "\n    \"delay" : ",\n    \"delay").text(std::to_string(profiles[i]))
+               .text("\": {\n      \"delay\": ").number(static_cast<double>(profiles[i]))
+               .text(",\n      \"type\": \"delay\"\n    }");
+        }
+        out.text(profiles.empty() ? "}\n}" : "\n  }\n}");
+        ok = out.flush();
+    }
+    fclose(input);
+    if (fclose(output) != 0 || !ok) {
+        printf("Error: cannot write '%s'\n", options.output.c_str());
+        return 1;
+    }
+
+    printf("Imported %" PRIu64 " of %" PRIu64 " jobs (%zu profiles, %" PRId64 " hosts) into %s\n",
+           counts.imported, counts.lines, profiles.size(), nb_res, options.output.c_str());
+    printf("Dropped: %" PRIu64 " cancelled, %" PRIu64 " without size, %" PRIu64 " without run time, %" PRIu64
+           " larger than the platform\n", counts.cancelled, counts.no_size, counts.no_runtime, counts.too_large);
+    if (counts.unsorted > 0) {
+        printf("Warning: %" PRIu64 " jobs were submitted before the first one and are submitted at 0\n", counts.unsorted);
+    }
+    return 0;
+}
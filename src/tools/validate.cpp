@@ -0,0 +1,395 @@
+// validate.cpp
+//
+// Checks that a Batsim schedule (jobs.csv) is feasible, fast enough to gate every benchmark run.
+// The jobs are turned into start/finish events sorted by time (O(n log n)), then swept once while
+// each host records the job holding it, so every check costs O(allocated hosts) per job:
+//   - exclusivity: no host is used by two jobs at the same time
+//   - allocation size: a job gets exactly the number of hosts it requested, all below --hosts
+//   - walltime: a job runs no longer than its requested time
+//   - submission: a job starts neither before its submission nor before time 0,
+//     and with --fcfs, jobs start in submission order
+// With --log, the counter lines of a backfilling scheduler log ("<total> <contiguous> <non_contiguous>")
+// are checked too: counters never decrease, total = contiguous + non_contiguous, and there are at least as
+// many contiguous (resp. non-contiguous) allocations in jobs.csv as the log claims contiguous (resp.
+// non-contiguous) backfills.
+//
+// Usage: validate <jobs.csv> [--log out/<algo>_log.txt] [--hosts n] [--fcfs] [--max-reports n]
+// Exits with status 1 if any violation is found.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "csv_reader.hpp"
+
+// Absolute tolerance on times, which Batsim writes with limited precision.
+const double TIME_EPSILON = 1e-6;
+
+struct ValidateOptions {
+    std::string jobs_path;
+    std::string log_path;
+    uint32_t nb_hosts = 0; // 0: not checked
+    bool fcfs = false;
+    uint64_t max_reports = 10;
+};
+
+struct ValidatedJob {
+    std::string_view id;
+    double submission_time;
+    double starting_time;
+    double finish_time;
+    double requested_time; // < 0 if unknown
+    int64_t requested_resources; // < 0 if unknown
+    std::string_view allocation;
+};
+
+enum Violation {
+    OVERLAP = 0,
+    ALLOCATION_SIZE,
+    HOST_OUT_OF_RANGE,
+    WALLTIME,
+    EARLY_START,
+    FCFS_ORDER,
+    LOG_FORMAT,
+    LOG_COUNTERS,
+    LOG_CONTIGUITY,
+    VIOLATION_COUNT
+};
+
+const char *violation_names[VIOLATION_COUNT] = {
+    "host used by two jobs", "allocation size", "host out of range", "walltime exceeded",
+    "started before submission", "FCFS order", "log format", "log counters", "log contiguity claims"};
+
+class Report {
+public:
+    explicit Report(uint64_t max_reports) : max_reports_(max_reports) {}
+
+    void add(Violation kind, const char *format, ...) __attribute__((format(printf, 3, 4))) {
+        if (counts_[kind]++ < max_reports_) {
+            printf("[%s] ", violation_names[kind]);
+            va_list args;
+            va_start(args, format);
+            vprintf(format, args);
+            va_end(args);
+            printf("\n");
+        }
+    }
+
+    uint64_t total() const {
+        uint64_t total = 0;
+        for (uint64_t count : counts_) {
+            total += count;
+        }
+        return total;
+    }
+
+    void print_summary() const {
+        for (int kind = 0; kind < VIOLATION_COUNT; ++kind) {
+            if (counts_[kind] > 0) {
+                printf("  %-28s %" PRIu64 "\n", violation_names[kind], counts_[kind]);
+            }
+        }
+    }
+
+private:
+    uint64_t max_reports_;
+    uint64_t counts_[VIOLATION_COUNT] = {};
+};
+
+static int printable_length(std::string_view text) {
+    return static_cast<int>(std::min<size_t>(text.size(), 64));
+}
+
+static bool read_jobs(std::string_view text, std::vector<ValidatedJob> &jobs, std::string &error) {
+    CsvReader reader(text);
+    std::vector<std::string_view> header, fields;
+    if (!reader.next_line(header)) {
+        error = "jobs.csv is empty";
+        return false;
+    }
+    int id_column = column(header, "job_id");
+    int submission_column = column(header, "submission_time");
+    int start_column = column(header, "starting_time");
+    int finish_column = column(header, "finish_time");
+    int requested_time_column = column(header, "requested_time");
+    int resources_column = column(header, "requested_number_of_resources");
+    int allocation_column = column(header, "allocated_resources");
+    if (id_column < 0 || submission_column < 0 || start_column < 0 || finish_column < 0 || allocation_column < 0) {
+        error = "jobs.csv misses one of the job_id, submission_time, starting_time, finish_time "
+                "and allocated_resources columns";
+        return false;
+    }
+    while (reader.next_line(fields)) {
+        ValidatedJob job;
+        if (static_cast<size_t>(allocation_column) >= fields.size() || fields[allocation_column].empty()
+            || !parse_number(fields, start_column, job.starting_time)
+            || !parse_number(fields, finish_column, job.finish_time)) {
+            continue; // rejected, or never started
+        }
+        job.id = fields[id_column];
+        job.allocation = fields[allocation_column];
+        if (!parse_number(fields, submission_column, job.submission_time)) {
+            job.submission_time = job.starting_time;
+        }
+        if (!parse_number(fields, requested_time_column, job.requested_time)) {
+            job.requested_time = -1;
+        }
+        double resources;
+        job.requested_resources = parse_number(fields, resources_column, resources) ? static_cast<int64_t>(resources) : -1;
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+struct ContiguityCounts {
+    uint64_t contiguous = 0;
+    uint64_t non_contiguous = 0;
+};
+
+static ContiguityCounts check_jobs(const std::vector<ValidatedJob> &jobs, const ValidateOptions &options, Report &report) {
+    ContiguityCounts contiguity;
+    for (const ValidatedJob &job : jobs) {
+        uint64_t nb_hosts = 0;
+        uint32_t out_of_range = UINT32_MAX;
+        size_t nb_intervals = for_each_interval(job.allocation, [&](uint32_t first, uint32_t last) {
+            nb_hosts += static_cast<uint64_t>(last - first) + 1;
+            if (options.nb_hosts > 0 && last >= options.nb_hosts) {
+                out_of_range = last;
+            }
+        });
+        (nb_intervals <= 1 ? contiguity.contiguous : contiguity.non_contiguous)++;
+        if (job.requested_resources >= 0 && nb_hosts != static_cast<uint64_t>(job.requested_resources)) {
+            report.add(ALLOCATION_SIZE, "job %.*s requested %" PRId64 " hosts and got %" PRIu64 " (%.*s)",
+                       printable_length(job.id), job.id.data(), job.requested_resources, nb_hosts,
+                       printable_length(job.allocation), job.allocation.data());
+        }
+        if (out_of_range != UINT32_MAX) {
+            report.add(HOST_OUT_OF_RANGE, "job %.*s uses host %u on a %u-host platform",
+                       printable_length(job.id), job.id.data(), out_of_range, options.nb_hosts);
+        }
+        if (job.requested_time > 0 && job.finish_time - job.starting_time > job.requested_time + TIME_EPSILON) {
+            report.add(WALLTIME, "job %.*s ran %.6g s for a walltime of %.6g s", printable_length(job.id),
+                       job.id.data(), job.finish_time - job.starting_time, job.requested_time);
+        }
+        if (job.starting_time < job.submission_time - TIME_EPSILON || job.starting_time < -TIME_EPSILON
+            || job.finish_time < job.starting_time - TIME_EPSILON) {
+            report.add(EARLY_START, "job %.*s submitted at %.6g, started at %.6g, finished at %.6g",
+                       printable_length(job.id), job.id.data(), job.submission_time, job.starting_time, job.finish_time);
+        }
+    }
+
+    if (options.fcfs) {
+        // Jobs in submission order (stable, so that simultaneous submissions keep the file order).
+        std::vector<uint32_t> order(jobs.size());
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return jobs[a].submission_time < jobs[b].submission_time;
+        });
+        double latest_start = -1;
+        uint32_t latest_job = 0;
+        for (uint32_t index : order) {
+            const ValidatedJob &job = jobs[index];
+            if (job.starting_time < latest_start - TIME_EPSILON) {
+                report.add(FCFS_ORDER, "job %.*s started at %.6g, before job %.*s submitted earlier (started at %.6g)",
+                           printable_length(job.id), job.id.data(), job.starting_time,
+                           printable_length(jobs[latest_job].id), jobs[latest_job].id.data(), latest_start);
+            } else if (job.starting_time > latest_start) {
+                latest_start = job.starting_time;
+                latest_job = index;
+            }
+        }
+    }
+    return contiguity;
+}
+
+// Sweeps the start and finish events in time order, finishes first at equal times
+// (a host freed at t can be used again at t).
+static void check_exclusivity(const std::vector<ValidatedJob> &jobs, Report &report) {
+    struct Event {
+        double time;
+        uint32_t job;
+        bool start;
+    };
+    std::vector<Event> events;
+    events.reserve(2 * jobs.size());
+    for (uint32_t i = 0; i < jobs.size(); ++i) {
+        events.push_back({jobs[i].starting_time, i, true});
+        events.push_back({std::max(jobs[i].finish_time, jobs[i].starting_time), i, false});
+    }
+    std::sort(events.begin(), events.end(), [](const Event &a, const Event &b) {
+        if (a.time != b.time) {
+            return a.time < b.time;
+        }
+        return a.start < b.start;
+    });
+
+    const uint32_t FREE = UINT32_MAX;
+    std::vector<uint32_t> owner; // job holding each host
+    for (const Event &event : events) {
+        const ValidatedJob &job = jobs[event.job];
+        for_each_interval(job.allocation, [&](uint32_t first, uint32_t last) {
+            if (last >= owner.size()) {
+                owner.resize(static_cast<size_t>(last) + 1, FREE);
+            }
+            for (uint64_t host = first; host <= last; ++host) {
+                if (event.start) {
+                    if (owner[host] != FREE) {
+                        const ValidatedJob &other = jobs[owner[host]];
+                        report.add(OVERLAP, "host %" PRIu64 ": job %.*s starts at %.6g while job %.*s runs until %.6g", host,
+                                   printable_length(job.id), job.id.data(), job.starting_time,
+                                   printable_length(other.id), other.id.data(), other.finish_time);
+                    }
+                    owner[host] = event.job;
+                } else if (owner[host] == event.job) {
+                    owner[host] = FREE;
+                }
+            }
+        });
+    }
+}
+
+static bool check_log(const std::string &path, const ContiguityCounts &contiguity, Report &report) {
+    MappedFile log;
+    if (!log.open(path)) {
+        printf("Error: cannot open '%s'\n", path.c_str());
+        return false;
+    }
+    std::string_view text = log.content();
+    uint64_t previous[3] = {0, 0, 0};
+    uint64_t line_number = 0;
+    bool has_counters = false;
+    size_t position = 0;
+    while (position < text.size()) {
+        size_t end = text.find('\n', position);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        std::string_view line = text.substr(position, end - position);
+        position = end + 1;
+        line_number++;
+        // Counter lines are made of three numbers; the header lines are not.
+        if (line.empty() || line[0] < '0' || line[0] > '9') {
+            continue;
+        }
+        uint64_t counters[3];
+        const char *cursor = line.data();
+        const char *line_end = line.data() + line.size();
+        bool ok = true;
+        for (int i = 0; i < 3 && ok; ++i) {
+            while (cursor < line_end && *cursor == ' ') {
+                cursor++;
+            }
+            auto parsed = std::from_chars(cursor, line_end, counters[i]);
+            ok = parsed.ec == std::errc();
+            cursor = parsed.ptr;
+        }
+        if (!ok) {
+            report.add(LOG_FORMAT, "line %" PRIu64 ": '%.*s' is not '<total> <contiguous> <non_contiguous>'",
+                       line_number, printable_length(line), line.data());
+            continue;
+        }
+        if (counters[0] != counters[1] + counters[2]) {
+            report.add(LOG_COUNTERS, "line %" PRIu64 ": %" PRIu64 " backfills but %" PRIu64 " + %" PRIu64 " by kind",
+                       line_number, counters[0], counters[1], counters[2]);
+        }
+        for (int i = 0; i < 3; ++i) {
+            if (counters[i] < previous[i]) {
+                report.add(LOG_COUNTERS, "line %" PRIu64 ": counter %d went from %" PRIu64 " down to %" PRIu64,
+                           line_number, i + 1, previous[i], counters[i]);
+            }
+            previous[i] = counters[i];
+        }
+        has_counters = true;
+    }
+    if (!has_counters) {
+        report.add(LOG_FORMAT, "no counter line in %s", path.c_str());
+        return true;
+    }
+    if (previous[1] > contiguity.contiguous) {
+        report.add(LOG_CONTIGUITY, "%" PRIu64 " contiguous backfills claimed, only %" PRIu64
+                   " contiguous allocations in the schedule", previous[1], contiguity.contiguous);
+    }
+    if (previous[2] > contiguity.non_contiguous) {
+        report.add(LOG_CONTIGUITY, "%" PRIu64 " non-contiguous backfills claimed, only %" PRIu64
+                   " non-contiguous allocations in the schedule", previous[2], contiguity.non_contiguous);
+    }
+    printf("Log: %" PRIu64 " backfills (%" PRIu64 " contiguous, %" PRIu64 " non-contiguous)\n",
+           previous[0], previous[1], previous[2]);
+    return true;
+}
+
+static bool parse_options(int argc, char **argv, ValidateOptions &options) {
+    if (argc < 2) {
+        return false;
+    }
+    options.jobs_path = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--fcfs") {
+            options.fcfs = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--log") {
+            options.log_path = value;
+        } else if (arg == "--hosts") {
+            options.nb_hosts = static_cast<uint32_t>(std::stoul(value));
+        } else if (arg == "--max-reports") {
+            options.max_reports = std::stoull(value);
+        } else {
+            printf("Unknown option '%s'\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    ValidateOptions options;
+    if (!parse_options(argc, argv, options)) {
+        printf("Usage: %s <jobs.csv> [--log out/<algo>_log.txt] [--hosts n] [--fcfs] [--max-reports n]\n", argv[0]);
+        return 1;
+    }
+    auto begin = std::chrono::steady_clock::now();
+    MappedFile input;
+    if (!input.open(options.jobs_path)) {
+        printf("Error: cannot open '%s'\n", options.jobs_path.c_str());
+        return 1;
+    }
+    std::vector<ValidatedJob> jobs;
+    std::string error;
+    if (!read_jobs(input.content(), jobs, error)) {
+        printf("Error: %s\n", error.c_str());
+        return 1;
+    }
+
+    Report report(options.max_reports);
+    ContiguityCounts contiguity = check_jobs(jobs, options, report);
+    check_exclusivity(jobs, report);
+    if (!options.log_path.empty() && !check_log(options.log_path, contiguity, report)) {
+        return 1;
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    printf("Checked %zu jobs (%" PRIu64 " contiguous, %" PRIu64 " non-contiguous allocations) in %.2f s\n",
+           jobs.size(), contiguity.contiguous, contiguity.non_contiguous, elapsed);
+    if (report.total() > 0) {
+        printf("INVALID: %" PRIu64 " violations\n", report.total());
+        report.print_summary();
+        return 1;
+    }
+    printf("VALID\n");
+    return 0;
+}
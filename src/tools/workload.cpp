@@ -0,0 +1,195 @@
+// workload.cpp
+//
+// Loading and generation of in-memory workloads, see workload.hpp.
+
+#include "workload.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+bool load_workload_json(const std::string &path, Workload &workload, std::string &error) {
+    std::ifstream input(path);
+    if (!input.is_open()) {
+        error = "cannot open workload file '" + path + "'";
+        return false;
+    }
+
+    json document = json::parse(input, nullptr, false);
+    if (document.is_discarded() || !document.is_object() || !document.contains("jobs")) {
+        error = "'" + path + "' is not a Batsim JSON workload";
+        return false;
+    }
+
+    workload = Workload();
+    workload.description = document.value("description", "");
+    workload.nb_res = document.value("nb_res", 0u);
+
+    const json empty = json::object();
+    const json &profiles = document.contains("profiles") ? document["profiles"] : empty;
+
+    workload.jobs.reserve(document["jobs"].size());
+    for (const auto &entry : document["jobs"]) {
+        WorkloadJob job;
+        job.id = entry["id"].is_string() ? entry["id"].get<std::string>() : entry["id"].dump();
+        job.profile = entry.value("profile", "");
+        job.subtime = entry.value("subtime", 0.0);
+        job.res = entry.value("res", 0u);
+        job.walltime = entry.value("walltime", -1.0);
+
+        // Only delay profiles are simulated, anything else runs for its walltime.
+        job.delay = job.walltime;
+        if (profiles.contains(job.profile)) {
+            const json &profile = profiles[job.profile];
+            if (profile.value("type", "") == "delay") {
+                job.delay = profile.value("delay", job.walltime);
+            }
+        }
+        workload.jobs.push_back(std::move(job));
+    }
+    return true;
+}
+
+bool parse_distribution(const std::string &text, Distribution &distribution, std::string &error) {
+    std::vector<std::string> parts;
+    size_t begin = 0;
+    while (true) {
+        size_t end = text.find(':', begin);
+        parts.push_back(text.substr(begin, end == std::string::npos ? std::string::npos : end - begin));
+        if (end == std::string::npos) {
+            break;
+        }
+        begin = end + 1;
+    }
+
+    std::vector<double> values;
+    for (size_t i = 1; i < parts.size(); ++i) {
+        char *end = nullptr;
+        double value = strtod(parts[i].c_str(), &end);
+        if (parts[i].empty() || *end != '\0' || value < 0) {
+            error = "invalid number '" + parts[i] + "' in distribution '" + text + "'";
+            return false;
+        }
+        values.push_back(value);
+    }
+
+    distribution = Distribution();
+    const std::string &kind = parts[0];
+    bool valid = false;
+    if (kind == "uniform" && values.size() == 2) {
+        distribution.kind = Distribution::UNIFORM;
+        valid = values[0] <= values[1];
+    } else if (kind == "loguniform" && values.size() == 2) {
+        distribution.kind = Distribution::LOG_UNIFORM;
+        valid = values[0] > 0 && values[0] <= values[1];
+    } else if (kind == "lublin" && values.size() <= 1) {
+        distribution.kind = Distribution::LUBLIN;
+        valid = values.empty() || values[0] >= 1;
+    } else if (kind == "poisson" && values.size() == 1) {
+        distribution.kind = Distribution::POISSON;
+        valid = values[0] > 0;
+    }
+    if (!valid) {
+        error = "invalid distribution '" + text + "' (expected uniform:a:b, loguniform:a:b, lublin[:max] or poisson:mean)";
+        return false;
+    }
+    distribution.a = values.size() > 0 ? values[0] : 0;
+    distribution.b = values.size() > 1 ? values[1] : distribution.a;
+    return true;
+}
+
+GeneratorSettings default_generator_settings(uint32_t max_hosts) {
+    GeneratorSettings settings;
+    settings.max_hosts = max_hosts;
+    settings.res = {Distribution::UNIFORM, 1, static_cast<double>(std::max(1u, std::min(3u, max_hosts)))};
+    settings.walltime = {Distribution::UNIFORM, 5, 30};
+    settings.subtime = {Distribution::UNIFORM, 0, 10};
+    return settings;
+}
+
+JobGenerator::JobGenerator(const GeneratorSettings &settings, uint64_t seed)
+    : settings_(settings), rng_(seed) {
+}
+
+double JobGenerator::draw(const Distribution &distribution) {
+    switch (distribution.kind) {
+        case Distribution::UNIFORM: {
+            std::uniform_int_distribution<uint32_t> uniform(static_cast<uint32_t>(distribution.a),
+                                                            static_cast<uint32_t>(distribution.b));
+            return uniform(rng_);
+        }
+        case Distribution::LOG_UNIFORM: {
+            std::uniform_real_distribution<double> exponent(std::log(distribution.a), std::log(distribution.b));
+            return std::round(std::exp(exponent(rng_)));
+        }
+        case Distribution::LUBLIN: {
+            // Lublin & Feitelson (2003), "The workload on parallel supercomputers": a share of serial
+            // jobs, then a two-stage uniform log2 size, rounded to a power of two most of the time.
+            const double serial_probability = 0.24, power_of_two_probability = 0.75;
+            const double low_probability = 0.86, low = 0.8;
+            double max_size = distribution.a > 0 ? distribution.a : settings_.max_hosts;
+            std::uniform_real_distribution<double> unit(0, 1);
+            if (max_size < 2 || unit(rng_) < serial_probability) {
+                return 1;
+            }
+            double high = std::log2(max_size);
+            double medium = std::max(low, high - 2.5);
+            double log_size = (unit(rng_) < low_probability)
+                ? std::uniform_real_distribution<double>(low, medium)(rng_)
+                : std::uniform_real_distribution<double>(medium, high)(rng_);
+            double size = (unit(rng_) < power_of_two_probability) ? std::exp2(std::round(log_size))
+                                                                  : std::round(std::exp2(log_size));
+            return std::min(size, max_size);
+        }
+        case Distribution::POISSON: {
+            std::exponential_distribution<double> interarrival(1.0 / distribution.a);
+            return interarrival(rng_);
+        }
+    }
+    return 0;
+}
+
+void JobGenerator::next(WorkloadJob &job) {
+    ++index_;
+    job.id = "job" + std::to_string(index_);
+    job.profile = "delay" + std::to_string(index_);
+
+    double res = draw(settings_.res);
+    job.res = static_cast<uint32_t>(std::max(1.0, std::min(res, static_cast<double>(std::max(1u, settings_.max_hosts)))));
+    job.walltime = std::max(1.0, draw(settings_.walltime));
+    job.delay = job.walltime;
+
+    // The first job is always submitted at time 0
+    if (index_ == 1) {
+        job.subtime = 0;
+    } else if (settings_.subtime.kind == Distribution::POISSON) {
+        arrival_time_ += draw(settings_.subtime);
+        job.subtime = std::floor(arrival_time_);
+    } else {
+        job.subtime = draw(settings_.subtime);
+    }
+}
+
+Workload generate_workload(uint32_t num_jobs, uint32_t max_hosts, uint64_t seed) {
+    JobGenerator generator(default_generator_settings(max_hosts), seed);
+
+    Workload workload;
+    workload.description = generated_workload_description(num_jobs, max_hosts);
+    workload.nb_res = max_hosts * 2;
+    workload.jobs.resize(num_jobs);
+    for (WorkloadJob &job : workload.jobs) {
+        generator.next(job);
+    }
+    return workload;
+}
+
+std::string generated_workload_description(uint64_t num_jobs, uint32_t max_hosts) {
+    return std::to_string(num_jobs) + " jobs with varied resource requirements (max "
+        + std::to_string(max_hosts) + " hosts) and execution times";
+}
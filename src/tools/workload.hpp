@@ -0,0 +1,104 @@
+// workload.hpp
+//
+// In-memory Batsim workload used by the native tools (simulator, sweep...).
+// Only what the schedulers of this project look at is kept: delay profiles,
+// requested resources, walltime and submission time.
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct WorkloadJob {
+    std::string id;        // id as written in the workload file, e.g. "job1"
+    std::string profile;   // profile name, e.g. "delay1"
+    double subtime = 0;
+    uint32_t res = 0;
+    double walltime = -1;  // <= 0 means no walltime
+    double delay = 0;      // execution time of the (delay) profile
+};
+
+// Read-only access to the jobs of a workload, whatever its storage:
+// Workload below keeps them in memory, MappedWorkload (binary_workload.hpp) reads a mapped file.
+class JobTable {
+public:
+    virtual ~JobTable() = default;
+
+    virtual size_t nb_jobs() const = 0;
+    virtual std::string_view job_id(size_t job) const = 0;
+    virtual std::string_view job_profile(size_t job) const = 0;
+    virtual double job_subtime(size_t job) const = 0;
+    virtual uint32_t job_res(size_t job) const = 0;
+    virtual double job_walltime(size_t job) const = 0;
+    virtual double job_delay(size_t job) const = 0;
+};
+
+struct Workload : public JobTable {
+    std::string description;
+    uint32_t nb_res = 0;
+    std::vector<WorkloadJob> jobs;
+
+    size_t nb_jobs() const override { return jobs.size(); }
+    std::string_view job_id(size_t job) const override { return jobs[job].id; }
+    std::string_view job_profile(size_t job) const override { return jobs[job].profile; }
+    double job_subtime(size_t job) const override { return jobs[job].subtime; }
+    uint32_t job_res(size_t job) const override { return jobs[job].res; }
+    double job_walltime(size_t job) const override { return jobs[job].walltime; }
+    double job_delay(size_t job) const override { return jobs[job].delay; }
+};
+
+// Loads a Batsim JSON workload (the format of assets/**/*.json).
+bool load_workload_json(const std::string &path, Workload &workload, std::string &error);
+
+// Distribution of a generated job attribute, written "<kind>:<a>[:<b>]":
+//   uniform:a:b      integer uniform in [a, b]
+//   loguniform:a:b   log-uniform in [a, b], rounded (many small values, a few huge ones)
+//   lublin:max       job sizes of the Lublin-Feitelson model: serial jobs, powers of two, up to max
+//   poisson:mean     arrival process with exponential inter-arrival times of the given mean (subtime only)
+struct Distribution {
+    enum Kind { UNIFORM, LOG_UNIFORM, LUBLIN, POISSON };
+    Kind kind = UNIFORM;
+    double a = 0;
+    double b = 0;
+};
+
+bool parse_distribution(const std::string &text, Distribution &distribution, std::string &error);
+
+struct GeneratorSettings {
+    uint32_t max_hosts = 1;
+    Distribution res;
+    Distribution walltime;
+    Distribution subtime;
+};
+
+// The distributions of scripts/generate_jobs.py: res in [1, min(3, max_hosts)],
+// walltime in [5, 30], subtime in [0, 10].
+GeneratorSettings default_generator_settings(uint32_t max_hosts);
+
+// Draws jobs one at a time, so that a workload of any size can be streamed.
+// The first job is always submitted at time 0, and its delay profile lasts for its walltime.
+// Two generators built with the same settings and seed produce the same jobs.
+class JobGenerator {
+public:
+    JobGenerator(const GeneratorSettings &settings, uint64_t seed);
+
+    void next(WorkloadJob &job);
+
+private:
+    double draw(const Distribution &distribution);
+
+    GeneratorSettings settings_;
+    std::mt19937_64 rng_;
+    uint64_t index_ = 0;
+    double arrival_time_ = 0;
+};
+
+// Generates a workload with the same distributions as scripts/generate_jobs.py,
+// but from a seeded generator so that a (num_jobs, max_hosts, seed) triple is reproducible.
+Workload generate_workload(uint32_t num_jobs, uint32_t max_hosts, uint64_t seed);
+
+// Description and platform size written by scripts/generate_jobs.py.
+std::string generated_workload_description(uint64_t num_jobs, uint32_t max_hosts);
@@ -0,0 +1,175 @@
+// workload2bin.cpp
+//
+// Converts a Batsim JSON workload into the columnar binary format of binary_workload.hpp.
+// The JSON is read with nlohmann's SAX interface, so no DOM of the whole workload is ever built:
+// jobs go straight into the columns, profiles only contribute their delay.
+//
+// Usage: workload2bin <workload.json> <workload.bin>
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "binary_workload.hpp"
+
+using json = nlohmann::json;
+
+// Follows the three levels a workload is made of:
+//   depth 1: {"description": .., "nb_res": .., "jobs": [..], "profiles": {..}}
+//   depth 3: a job object inside "jobs", or a profile object inside "profiles"
+// Anything deeper (e.g. the sequence of a composed profile) is skipped.
+class WorkloadSax : public nlohmann::json_sax<json> {
+public:
+    explicit WorkloadSax(BinaryWorkloadWriter &writer) : writer_(writer) {}
+
+    bool null() override { return scalar(std::string(), false); }
+    bool boolean(bool) override { return scalar(std::string(), false); }
+    bool number_integer(number_integer_t value) override { return number(static_cast<double>(value), std::to_string(value)); }
+    bool number_unsigned(number_unsigned_t value) override { return number(static_cast<double>(value), std::to_string(value)); }
+    bool number_float(number_float_t value, const string_t &text) override { return number(value, text); }
+    bool string(string_t &value) override { return scalar(value, true); }
+    bool binary(binary_t &) override { return scalar(std::string(), false); }
+
+    bool start_object(std::size_t) override {
+        ++depth_;
+        if (depth_ == 3) {
+            job_ = PendingJob();
+            profile_type_.clear();
+            profile_delay_ = -1;
+        }
+        return true;
+    }
+
+    bool end_object() override {
+        if (depth_ == 3 && section_ == JOBS) {
+            writer_.add_job(job_.id, job_.profile, job_.subtime, job_.res, job_.walltime);
+            nb_jobs_++;
+        } else if (depth_ == 3 && section_ == PROFILES && profile_type_ == "delay" && profile_delay_ >= 0) {
+            writer_.set_profile_delay(profile_name_, profile_delay_);
+        }
+        --depth_;
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        ++depth_;
+        return true;
+    }
+
+    bool end_array() override {
+        --depth_;
+        return true;
+    }
+
+    bool key(string_t &name) override {
+        if (depth_ == 1) {
+            section_ = (name == "jobs") ? JOBS : (name == "profiles") ? PROFILES : OTHER;
+            top_key_ = name;
+        } else if (depth_ == 2 && section_ == PROFILES) {
+            profile_name_ = name;
+        } else if (depth_ == 3) {
+            key_ = name;
+        }
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string &, const nlohmann::detail::exception &error) override {
+        error_ = "invalid JSON at byte " + std::to_string(position) + ": " + error.what();
+        return false;
+    }
+
+    uint64_t nb_jobs() const { return nb_jobs_; }
+    const std::string &error() const { return error_; }
+
+private:
+    enum Section { OTHER, JOBS, PROFILES };
+
+    struct PendingJob {
+        std::string id;
+        std::string profile;
+        double subtime = 0;
+        uint32_t res = 0;
+        double walltime = -1;
+    };
+
+    bool number(double value, const std::string &text) {
+        if (depth_ == 1 && top_key_ == "nb_res") {
+            writer_.set_nb_res(static_cast<uint32_t>(value));
+        } else if (depth_ == 3 && section_ == JOBS) {
+            if (key_ == "id") {
+                job_.id = text;
+            } else if (key_ == "subtime") {
+                job_.subtime = value;
+            } else if (key_ == "res") {
+                job_.res = static_cast<uint32_t>(value);
+            } else if (key_ == "walltime") {
+                job_.walltime = value;
+            }
+        } else if (depth_ == 3 && section_ == PROFILES && key_ == "delay") {
+            profile_delay_ = value;
+        }
+        return true;
+    }
+
+    bool scalar(const std::string &value, bool is_string) {
+        if (!is_string) {
+            return true;
+        }
+        if (depth_ == 1 && top_key_ == "description") {
+            writer_.set_description(value);
+        } else if (depth_ == 3 && section_ == JOBS) {
+            if (key_ == "id") {
+                job_.id = value;
+            } else if (key_ == "profile") {
+                job_.profile = value;
+            }
+        } else if (depth_ == 3 && section_ == PROFILES && key_ == "type") {
+            profile_type_ = value;
+        }
+        return true;
+    }
+
+    BinaryWorkloadWriter &writer_;
+    int depth_ = 0;
+    Section section_ = OTHER;
+    std::string top_key_;
+    std::string key_;
+    PendingJob job_;
+    std::string profile_name_;
+    std::string profile_type_;
+    double profile_delay_ = -1;
+    uint64_t nb_jobs_ = 0;
+    std::string error_;
+};
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        printf("Usage: %s <workload.json> <workload.bin>\n", argv[0]);
+        return 1;
+    }
+    std::ifstream input(argv[1], std::ios::binary);
+    if (!input.is_open()) {
+        printf("Error: cannot open '%s'\n", argv[1]);
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    BinaryWorkloadWriter writer;
+    WorkloadSax sax(writer);
+    if (!json::sax_parse(input, &sax)) {
+        printf("Error: %s: %s\n", argv[1], sax.error().c_str());
+        return 1;
+    }
+    std::string error;
+    if (!writer.write(argv[2], error)) {
+        printf("Error: %s\n", error.c_str());
+        return 1;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    printf("Converted %" PRIu64 " jobs from %s into %s in %.2f s\n", sax.nb_jobs(), argv[1], argv[2], elapsed);
+    return 0;
+}
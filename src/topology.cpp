@@ -0,0 +1,172 @@
+// topology.cpp
+//
+// Switch-aware contiguous allocations, see topology.hpp.
+
+#include "topology.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+
+#include "slot_profile.hpp"
+
+bool Topology::load(const std::string &path) {
+    clear();
+    std::ifstream file(path);
+    if (!file) {
+        printf("Could not open topology file '%s'\n", path.c_str());
+        return false;
+    }
+    auto document = nlohmann::json::parse(file, nullptr, false);
+    if (document.is_discarded() || !document.is_object() || !document.contains("switches")
+        || !document["switches"].is_array()) {
+        printf("Topology file '%s' is not a JSON object with a \"switches\" array\n", path.c_str());
+        return false;
+    }
+    for (const auto &entry : document.items()) {
+        if (entry.key() != "switches") {
+            printf("Topology file '%s': unsupported key \"%s\" (only \"switches\" is read, not zones or coordinates)\n",
+                   path.c_str(), entry.key().c_str());
+            return false;
+        }
+    }
+    if (document["switches"].empty()) {
+        printf("Topology file '%s' lists no switch\n", path.c_str());
+        return false;
+    }
+    for (const auto &hosts : document["switches"]) {
+        if (!hosts.is_array()) {
+            printf("Topology file '%s': every switch must be an array of host ids\n", path.c_str());
+            clear();
+            return false;
+        }
+        uint32_t switch_index = static_cast<uint32_t>(switch_sizes_.size());
+        switch_sizes_.push_back(0);
+        for (const auto &host : hosts) {
+            if (!host.is_number_unsigned()) {
+                printf("Topology file '%s': host ids must be non-negative integers\n", path.c_str());
+                clear();
+                return false;
+            }
+            uint32_t id = host.get<uint32_t>();
+            if (id >= host_switch_.size()) {
+                host_switch_.resize(id + 1, NO_SWITCH);
+            }
+            if (host_switch_[id] != NO_SWITCH) {
+                printf("Topology file '%s': host %u is listed twice\n", path.c_str(), id);
+                clear();
+                return false;
+            }
+            host_switch_[id] = switch_index;
+            switch_sizes_[switch_index]++;
+        }
+    }
+
+    std::vector<uint32_t> sizes = switch_sizes_;
+    std::sort(sizes.begin(), sizes.end(), std::greater<uint32_t>());
+    uint32_t total = 0;
+    for (uint32_t size : sizes) {
+        total += size;
+        capacity_prefix_.push_back(total);
+    }
+    return true;
+}
+
+void Topology::clear() {
+    host_switch_.clear();
+    switch_sizes_.clear();
+    capacity_prefix_.clear();
+}
+
+uint32_t Topology::min_span(uint32_t nb_hosts) const {
+    auto it = std::lower_bound(capacity_prefix_.begin(), capacity_prefix_.end(), nb_hosts);
+    if (it != capacity_prefix_.end()) {
+        return static_cast<uint32_t>(it - capacity_prefix_.begin()) + 1;
+    }
+    // The hosts listed under no switch are switches of their own.
+    uint32_t listed = capacity_prefix_.empty() ? 0 : capacity_prefix_.back();
+    return static_cast<uint32_t>(capacity_prefix_.size()) + (nb_hosts - listed);
+}
+
+bool Topology::find_contiguous(const std::set<uint32_t> &available, uint32_t nb_hosts, std::vector<uint32_t> &hosts) const {
+    if (!loaded()) {
+        if (find_contiguous_run(available, nb_hosts, hosts)) {
+            return true;
+        }
+        hosts.clear();
+        return false;
+    }
+    hosts.clear();
+    if (available.size() < nb_hosts) {
+        return false;
+    }
+
+    // Free hosts per switch, in one pass over the free hosts.
+    std::vector<uint32_t> free_hosts(switch_sizes_.size(), 0);
+    uint32_t free_alone = 0;
+    for (uint32_t host : available) {
+        uint32_t switch_index = (host < host_switch_.size()) ? host_switch_[host] : NO_SWITCH;
+        if (switch_index == NO_SWITCH) {
+            free_alone++;
+        } else {
+            free_hosts[switch_index]++;
+        }
+    }
+    std::vector<uint32_t> order;
+    for (uint32_t switch_index = 0; switch_index < free_hosts.size(); ++switch_index) {
+        if (free_hosts[switch_index] > 0) {
+            order.push_back(switch_index);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&free_hosts](uint32_t a, uint32_t b) {
+        return free_hosts[a] != free_hosts[b] ? free_hosts[a] > free_hosts[b] : a < b;
+    });
+
+    // The fullest switches first span the fewest.
+    size_t nb_switches = 0;
+    uint32_t total = 0;
+    while (nb_switches < order.size() && total < nb_hosts) {
+        total += free_hosts[order[nb_switches++]];
+    }
+    uint32_t nb_alone = (total < nb_hosts) ? nb_hosts - total : 0;
+    if (nb_switches + nb_alone > min_span(nb_hosts)) {
+        return false;
+    }
+    std::vector<uint32_t> &quota = free_hosts;
+    if (nb_alone == 0 && nb_switches > 0) {
+        // Best fit for the last switch: the switches that could replace it follow it in order.
+        uint32_t needed = nb_hosts - (total - free_hosts[order[nb_switches - 1]]);
+        size_t best = nb_switches - 1;
+        while (best + 1 < order.size() && free_hosts[order[best + 1]] >= needed) {
+            best++;
+        }
+        std::swap(order[nb_switches - 1], order[best]);
+        quota[order[nb_switches - 1]] = needed;
+    }
+    for (size_t i = nb_switches; i < order.size(); ++i) {
+        quota[order[i]] = 0;
+    }
+
+    for (uint32_t host : available) {
+        uint32_t switch_index = (host < host_switch_.size()) ? host_switch_[host] : NO_SWITCH;
+        if (switch_index == NO_SWITCH) {
+            if (nb_alone > 0) {
+                hosts.push_back(host);
+                nb_alone--;
+            }
+        } else if (quota[switch_index] > 0) {
+            hosts.push_back(host);
+            quota[switch_index]--;
+        }
+    }
+    return true;
+}
+
+bool topology_init(const EdcConfig &config, Topology &topology) {
+    topology.clear();
+    if (!config.has("topology_file")) {
+        return true;
+    }
+    return topology.load(config.get_string("topology_file", ""));
+}
@@ -0,0 +1,57 @@
+// topology.hpp
+//
+// Network locality of the hosts, for the contiguous schedulers (best_cont, force_cont).
+// Without a topology, contiguous means consecutive host ids (best_cont searches them with
+// find_contiguous_run(), force_cont with find_contiguous_hosts() and its "placement", both in
+// slot_profile.hpp), but host ids are only the order of the <host> entries of the platform file.
+// A topology file groups the hosts by the switch they are connected to:
+//   {"switches": [[0, 1, 2, 3], [4, 5, 6, 7], ...]}
+// A host listed under no switch counts as a switch of its own. An allocation is then contiguous
+// if it spans as few switches as any allocation of that many hosts can on the platform.
+// Only switch groups are read: a file with any other key (zones, coordinates) or without any
+// switch is refused, and so the scheduler fails to initialize instead of falling back to
+// consecutive host ids, which only happens when there is no "topology_file" at all.
+// Init data key:
+//   "topology_file": path of the topology file   (none by default: consecutive host ids)
+
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "edc_config.hpp"
+
+class Topology {
+public:
+    // Reads a topology file. Returns false (and prints why) if it cannot be read, is not valid
+    // JSON, has a key other than "switches", lists no switch, or lists a host twice.
+    bool load(const std::string &path);
+
+    // Back to consecutive host ids.
+    void clear();
+
+    bool loaded() const { return !switch_sizes_.empty(); }
+
+    // Sets hosts to nb_hosts contiguous hosts of available and returns true, or clears hosts and
+    // returns false if there are none. With a topology, the fewest switches are used, the fullest
+    // first, and the last one is the switch with the fewest free hosts that is enough (best fit),
+    // so that larger holes stay for larger jobs. Only reads the topology: may be called from
+    // several threads at once.
+    bool find_contiguous(const std::set<uint32_t> &available, uint32_t nb_hosts, std::vector<uint32_t> &hosts) const;
+
+    // Fewest switches an allocation of nb_hosts hosts can span on the platform.
+    uint32_t min_span(uint32_t nb_hosts) const;
+
+private:
+    static constexpr uint32_t NO_SWITCH = UINT32_MAX;
+
+    std::vector<uint32_t> host_switch_;       // Switch of each host id, NO_SWITCH if none
+    std::vector<uint32_t> switch_sizes_;      // Hosts of each switch
+    std::vector<uint32_t> capacity_prefix_;   // Hosts of the i + 1 largest switches
+};
+
+// Loads the "topology_file" of the init data into topology, or clears it if there is none.
+// Call from batsim_edc_init(), after parse_edc_config(). Returns false if the file cannot be loaded.
+bool topology_init(const EdcConfig &config, Topology &topology);
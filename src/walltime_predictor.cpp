@@ -0,0 +1,117 @@
+// walltime_predictor.cpp
+//
+// Run time predictions from the last completed jobs, see walltime_predictor.hpp.
+
+#include "walltime_predictor.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Last runs of the jobs sharing a key, as a ring buffer.
+struct History {
+    std::vector<double> runtimes;
+    size_t next = 0;
+    double sum = 0;
+};
+
+enum KeyLevel {
+    KEY_PROFILE = 0,
+    KEY_HOSTS_WALLTIME,
+    KEY_WALLTIME,
+    NB_KEY_LEVELS
+};
+
+bool enabled = false;
+size_t history_length = 2;
+bool user_tag = false;
+uint64_t nb_observed = 0;
+std::unordered_map<std::string, History> histories[NB_KEY_LEVELS];
+
+std::string make_key(KeyLevel level, const std::string &job_id, const std::string &profile_id,
+                     uint32_t nb_hosts, double walltime) {
+    std::string key;
+    if (user_tag) {
+        key = job_id.substr(0, job_id.find('!'));
+        key += '|';
+    }
+    switch (level) {
+        case KEY_PROFILE:
+            key += profile_id;
+            break;
+        case KEY_HOSTS_WALLTIME:
+            key += std::to_string(nb_hosts);
+            key += '|';
+            key += std::to_string(walltime);
+            break;
+        default:
+            key += std::to_string(walltime);
+            break;
+    }
+    return key;
+}
+
+} // namespace
+
+bool walltime_predictor_init(const EdcConfig &config) {
+    for (auto &level : histories) {
+        level.clear();
+    }
+    nb_observed = 0;
+    std::string mode = config.get_string("walltime_prediction", "none");
+    if (mode != "none" && mode != "history") {
+        printf("Unknown walltime prediction '%s' (expected none or history)\n", mode.c_str());
+        return false;
+    }
+    enabled = (mode == "history");
+    history_length = static_cast<size_t>(std::max(1.0, config.get_number("prediction_history", 2)));
+    user_tag = config.get_bool("prediction_user_tag", false);
+    return true;
+}
+
+bool walltime_predictor_enabled() {
+    return enabled;
+}
+
+double walltime_predictor_predict(const std::string &job_id, const std::string &profile_id,
+                                  uint32_t nb_hosts, double walltime) {
+    if (!enabled) {
+        return walltime;
+    }
+    for (int level = KEY_PROFILE; level < NB_KEY_LEVELS; ++level) {
+        auto it = histories[level].find(make_key(static_cast<KeyLevel>(level), job_id, profile_id, nb_hosts, walltime));
+        if (it == histories[level].end()) {
+            continue;
+        }
+        // At least a second, so that a prediction is never taken for a missing walltime
+        double mean = std::max(it->second.sum / it->second.runtimes.size(), 1.0);
+        return (walltime > 0) ? std::min(mean, walltime) : mean;
+    }
+    return walltime;
+}
+
+uint64_t walltime_predictor_nb_observed() {
+    return nb_observed;
+}
+
+void walltime_predictor_observe(const std::string &job_id, const std::string &profile_id,
+                                uint32_t nb_hosts, double walltime, double runtime) {
+    if (!enabled) {
+        return;
+    }
+    for (int level = KEY_PROFILE; level < NB_KEY_LEVELS; ++level) {
+        History &history = histories[level][make_key(static_cast<KeyLevel>(level), job_id, profile_id, nb_hosts, walltime)];
+        if (history.runtimes.size() < history_length) {
+            history.runtimes.push_back(runtime);
+        } else {
+            history.sum -= history.runtimes[history.next];
+            history.runtimes[history.next] = runtime;
+            history.next = (history.next + 1) % history_length;
+        }
+        history.sum += runtime;
+    }
+    nb_observed++;
+}
@@ -0,0 +1,47 @@
+// walltime_predictor.hpp
+//
+// Online prediction of job run times, for the schedulers that plan with the walltimes of the jobs.
+// Requested walltimes are upper bounds that users overestimate a lot, which makes shadow times and
+// reservations pessimistic. The predictor learns from the jobs that completed: a job is predicted
+// to run as long as the mean of the last runs of the most similar jobs, looked up from the most
+// specific key to the least specific one:
+//   1. same profile
+//   2. same requested hosts and walltime
+//   3. same requested walltime
+// With "prediction_user_tag", every key also includes the part of the job id before '!' (the
+// Batsim workload name, e.g. one workload per user). Predictions never exceed the requested walltime,
+// which stays what the job is killed at: a job without any similar completed job is predicted to
+// run for its walltime, and so is a job that ran past its prediction, as soon as the scheduler
+// notices it.
+// Init data keys:
+//   "walltime_prediction": "none" | "history"   ("none" by default: predictions are the walltimes)
+//   "prediction_history": n                     (runs averaged per key, 2 by default)
+//   "prediction_user_tag": true | false         (false by default)
+// Schedulers predict the run time of a waiting job when they plan it or start it, not when it is
+// submitted, so that it benefits from the jobs that completed while it waited.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "edc_config.hpp"
+
+// Reads the init data keys and forgets what was learned. Call from batsim_edc_init(), after
+// parse_edc_config(). Returns false (and prints why) if "walltime_prediction" is not a known mode.
+bool walltime_predictor_init(const EdcConfig &config);
+
+bool walltime_predictor_enabled();
+
+// Predicted run time of a job, <= walltime. walltime <= 0 if the job gives none, in which case
+// the prediction is also <= 0 until a similar job completed.
+double walltime_predictor_predict(const std::string &job_id, const std::string &profile_id,
+                                  uint32_t nb_hosts, double walltime);
+
+// Number of runs learned since walltime_predictor_init(): predictions made since it last changed
+// are still up to date.
+uint64_t walltime_predictor_nb_observed();
+
+// Learns that a job ran for runtime seconds.
+void walltime_predictor_observe(const std::string &job_id, const std::string &profile_id,
+                                uint32_t nb_hosts, double walltime, double runtime);